@@ -2,9 +2,23 @@
 #define BF_ALL_HPP
 
 #include "bf/bloom_filter/a2.hpp"
+#include "bf/bloom_filter/age_partitioned.hpp"
 #include "bf/bloom_filter/basic.hpp"
+#include "bf/bloom_filter/bitsliced.hpp"
 #include "bf/bloom_filter/bitwise.hpp"
+#include "bf/bloom_filter/count_min.hpp"
 #include "bf/bloom_filter/counting.hpp"
+#include "bf/bloom_filter/cuckoo.hpp"
+#include "bf/bloom_filter/expiring.hpp"
+#include "bf/bloom_filter/fuse.hpp"
+#include "bf/bloom_filter/quotient.hpp"
+#include "bf/bloom_filter/range.hpp"
+#include "bf/bloom_filter/ribbon.hpp"
+#include "bf/bloom_filter/scalable.hpp"
 #include "bf/bloom_filter/stable.hpp"
+#include "bf/evaluation.hpp"
+#include "bf/iblt.hpp"
+#include "bf/merge.hpp"
+#include "bf/static_function.hpp"
 
 #endif
@@ -12,6 +12,7 @@ namespace bf {
 class bitvector
 {
   friend std::string to_string(bitvector const&, bool, size_t);
+  friend class counter_vector;
 
 public:
   typedef size_t block_type;
@@ -107,6 +108,24 @@ public:
   friend bool operator!=(bitvector const& x, bitvector const& y);
   friend bool operator<(bitvector const& x, bitvector const& y);
 
+  /// Counts the 1-bits of two bit vectors and of their intersection in a
+  /// single pass, without materializing `x & y`. The union count follows as
+  /// `cx + cy - cxy`.
+  ///
+  /// @param x The first bit vector.
+  ///
+  /// @param y The second bit vector.
+  ///
+  /// @param cx Receives `x.count()`.
+  ///
+  /// @param cy Receives `y.count()`.
+  ///
+  /// @param cxy Receives `(x & y).count()`.
+  ///
+  /// @pre `x.size() == y.size()`
+  friend void count_joint(bitvector const& x, bitvector const& y,
+                          size_type& cx, size_type& cy, size_type& cxy);
+
   //
   // Basic operations
   //
@@ -203,6 +222,11 @@ public:
   /// @return A const-reference to the bit at position *i*.
   const_reference operator[](size_type i) const;
 
+  /// Hints the processor to load the block containing a given bit into the
+  /// cache, so that a subsequent access does not stall.
+  /// @param i The bit position.
+  void prefetch(size_type i) const;
+
   /// Counts the number of 1-bits in the bit vector. Also known as *population
   /// count* or *Hamming weight*.
   /// @return The number of bits set to 1.
@@ -212,6 +236,14 @@ public:
   /// @param The number of blocks that represent `size()` bits.
   size_type blocks() const;
 
+  /// Retrieves the underlying blocks, e.g., to process them in bulk.
+  /// @return A pointer to the first of `blocks()` blocks.
+  block_type* data();
+
+  /// Retrieves the underlying blocks.
+  /// @return A pointer to the first of `blocks()` blocks.
+  block_type const* data() const;
+
   /// Retrieves the number of bits the bitvector consist of.
   /// @return The length of the bit vector in bits.
   size_type size() const;
@@ -1,6 +1,7 @@
 #ifndef BF_BLOOM_FILTER_HPP
 #define BF_BLOOM_FILTER_HPP
 
+#include <vector>
 #include <bf/wrap.hpp>
 
 namespace bf {
@@ -13,6 +14,8 @@ class bloom_filter
 
 public:
   bloom_filter() = default;
+  bloom_filter(bloom_filter&&) = default;
+  bloom_filter& operator=(bloom_filter&&) = default;
   virtual ~bloom_filter() = default;
 
   /// Adds an element to the Bloom filter.
@@ -28,6 +31,10 @@ public:
   /// @param o A wrapped object.
   virtual void add(object const& o) = 0;
 
+  /// Adds a batch of elements to the Bloom filter.
+  /// @param os The wrapped objects to add.
+  virtual void add(std::vector<object> const& os);
+
   /// Retrieves the count of an element.
   /// @tparam T The type of the element to query.
   /// @param x An instance of type `T`.
@@ -43,6 +50,12 @@ public:
   /// @return A frequency estimate for *o*.
   virtual size_t lookup(object const& o) const = 0;
 
+  /// Retrieves the counts of a batch of elements. Implementations may
+  /// overlap the memory accesses of multiple elements.
+  /// @param os The wrapped objects to query.
+  /// @return The frequency estimates for *os*, in the same order.
+  virtual std::vector<size_t> lookup(std::vector<object> const& os) const;
+
   /// Removes all items from the Bloom filter.
   virtual void clear() = 0;
 };
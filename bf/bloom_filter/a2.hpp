@@ -45,7 +45,32 @@ public:
   virtual size_t lookup(object const& o) const override;
   virtual void clear() override;
 
+  /// Adds the elements of another filter in place by merging the halves
+  /// with equal hashers. Since the halves swap roles on every rotation, the
+  /// active half of this filter may absorb the passive half of *other*.
+  /// @param other The other @f$A^2@f$ Bloom filter.
+  /// @throws std::invalid_argument if the halves cannot be paired or the
+  /// capacities differ.
+  void merge(a2_bloom_filter const& other);
+
+  /// Intersects this filter with another filter in place by intersecting
+  /// the halves with equal hashers.
+  /// @param other The other @f$A^2@f$ Bloom filter.
+  /// @throws std::invalid_argument if the halves cannot be paired or the
+  /// capacities differ.
+  void intersect(a2_bloom_filter const& other);
+
+  /// Retrieves the number of bits of both Bloom filters.
+  size_t bits() const;
+
 private:
+  /// Pairs the halves of two filters by compatibility.
+  /// @param other The other @f$A^2@f$ Bloom filter.
+  /// @return `true` if the active half of this filter pairs with the passive
+  /// half of *other*, and `false` if the halves pair in order.
+  /// @throws std::invalid_argument if the filters are incompatible.
+  bool crossed(a2_bloom_filter const& other) const;
+
   basic_bloom_filter first_;
   basic_bloom_filter second_;
   size_t items_ = 0; ///< Number of items in the active Bloom filter.
@@ -0,0 +1,130 @@
+#ifndef BF_BLOOM_FILTER_AGE_PARTITIONED_HPP
+#define BF_BLOOM_FILTER_AGE_PARTITIONED_HPP
+
+#include <vector>
+#include <bf/bitvector.hpp>
+#include <bf/bloom_filter.hpp>
+#include <bf/hash.hpp>
+
+namespace bf {
+
+/// An age-partitioned Bloom filter for sliding windows.
+///
+/// The filter consists of a ring of *k + l* slices of *m* bits each. An
+/// insertion sets one bit in each of the *k* newest slices, and a lookup
+/// reports an element iff *k* consecutive slices contain its bits. After
+/// every *g* insertions, a generation ends: the oldest slice is cleared and
+/// becomes the newest. Hence an element remains in the filter for at least
+/// *l* full generations, so that the filter has no false negatives for the
+/// last @f$l \cdot g@f$ insertions, and forgets an element after
+/// @f$(l + k) \cdot g@f$ insertions at the latest.
+///
+/// Each element is hashed once; the bit in each slice derives from the
+/// digest offset by the physical position of the slice and scrambled with
+/// the MurmurHash3 finalizer, so that bits remain valid as slices age and
+/// stay independent across slices.
+///
+/// Reference: Shtul, Baquero, and Almeida, "Age-Partitioned Bloom Filters",
+/// 2020.
+class age_partitioned_bloom_filter : public bloom_filter
+{
+public:
+  /// Computes the worst-case false-positive rate, which occurs at the end of
+  /// a generation.
+  ///
+  /// @param k The number of slices per element.
+  ///
+  /// @param l The number of additional slices.
+  ///
+  /// @param cells The number of bits per slice.
+  ///
+  /// @param generation The number of insertions per generation.
+  ///
+  /// @return The probability that *k* consecutive slices report an element
+  /// that was not inserted.
+  static double fp_rate(size_t k, size_t l, size_t cells, size_t generation);
+
+  /// Constructs an age-partitioned Bloom filter.
+  ///
+  /// @param k The number of slices per element.
+  ///
+  /// @param l The number of additional slices.
+  ///
+  /// @param cells The number of bits per slice.
+  ///
+  /// @param generation The number of insertions per generation.
+  ///
+  /// @param seed The seed of the hash function.
+  ///
+  /// @pre `k > 0 && l > 0 && cells > 0 && generation > 0`
+  age_partitioned_bloom_filter(size_t k, size_t l, size_t cells,
+                               size_t generation, size_t seed = 0);
+
+  /// Constructs an age-partitioned Bloom filter for a sliding window. The
+  /// implementation searches for the values of *k* and *l* that minimize
+  /// the total number of bits.
+  ///
+  /// @param fp The maximum false-positive rate.
+  ///
+  /// @param window The minimum number of most recent insertions without
+  /// false negatives.
+  ///
+  /// @param seed The seed of the hash function.
+  ///
+  /// @pre `0 < fp < 1 && window > 0`
+  age_partitioned_bloom_filter(double fp, size_t window, size_t seed = 0);
+
+  age_partitioned_bloom_filter(age_partitioned_bloom_filter&&) = default;
+
+  using bloom_filter::add;
+  using bloom_filter::lookup;
+
+  /// Adds an element to the *k* newest slices, starting a new generation
+  /// first if the current one is full.
+  /// @param o The object to add.
+  virtual void add(object const& o) override;
+
+  virtual size_t lookup(object const& o) const override;
+
+  virtual void clear() override;
+
+  /// Ends the current generation by clearing the oldest slice and making it
+  /// the newest. Applications may call this function on a timer to obtain
+  /// time-based windows.
+  void rotate();
+
+  /// Retrieves the number of slices per element.
+  size_t k() const;
+
+  /// Retrieves the number of additional slices.
+  size_t l() const;
+
+  /// Retrieves the number of bits per slice.
+  size_t cells() const;
+
+  /// Retrieves the number of insertions per generation.
+  size_t generation() const;
+
+  /// Retrieves the number of most recent insertions without false negatives.
+  size_t window() const;
+
+private:
+  /// Computes the bit of a digest in a given physical slice.
+  size_t index(digest d, size_t slice) const;
+
+  /// Maps an age to a physical slice, where age 0 is the newest slice.
+  size_t physical(size_t age) const;
+
+  size_t k_;
+  size_t l_;
+  size_t cells_;
+  size_t generation_;
+  default_hash_function hash_;
+  std::vector<bitvector> slices_;
+  size_t newest_ = 0;
+  size_t count_ = 0; ///< The number of insertions in the current generation.
+};
+
+} // namespace bf
+
+#endif
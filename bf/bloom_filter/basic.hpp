@@ -1,10 +1,14 @@
 #ifndef BF_BLOOM_FILTER_BASIC_HPP
 #define BF_BLOOM_FILTER_BASIC_HPP
 
+#include <functional>
+#include <iosfwd>
 #include <random>
+#include <string>
 #include <bf/bitvector.hpp>
 #include <bf/bloom_filter.hpp>
 #include <bf/hash.hpp>
+#include <bf/metrics.hpp>
 
 namespace bf {
 
@@ -63,10 +67,37 @@ public:
   ///
   /// @param hasher The hasher to use.
   /// @param bitvector the underlying bitvector of the bf.
-  basic_bloom_filter(hasher h, bitvector b);
+  /// @param partition Whether the bit vector is partitioned per hash function.
+  basic_bloom_filter(hasher h, bitvector b, bool partition = false);
 
   basic_bloom_filter(basic_bloom_filter&&);
 
+  /// Loads a filter from a stream and rebuilds its hasher from the
+  /// descriptor that ::save records.
+  /// @param in The stream to read from.
+  /// @return The deserialized filter.
+  /// @throws std::runtime_error if *in* does not contain a valid filter or
+  /// the filter has a custom hasher.
+  static basic_bloom_filter load(std::istream& in);
+
+  /// Loads a filter from a file by mapping it into memory, which avoids
+  /// reading the file through a stream, and rebuilds its hasher.
+  /// @param filename The file written by ::save.
+  /// @return The deserialized filter.
+  /// @throws std::runtime_error if the file does not contain a valid filter
+  /// or the filter has a custom hasher.
+  static basic_bloom_filter load(std::string const& filename);
+
+  /// Loads a filter from a stream with a given hasher, e.g., a custom hasher
+  /// that has no descriptor. The loader verifies the hasher against the
+  /// fingerprint that ::save records.
+  /// @param in The stream to read from.
+  /// @param h The hasher the filter was constructed with.
+  /// @return The deserialized filter.
+  /// @throws std::runtime_error if *in* does not contain a valid filter or
+  /// *h* does not match it.
+  static basic_bloom_filter load(std::istream& in, hasher h);
+
   using bloom_filter::add;
   using bloom_filter::lookup;
 
@@ -74,6 +105,39 @@ public:
   virtual size_t lookup(object const& o) const override;
   virtual void clear() override;
 
+  /// Adds a range of elements using multiple threads. The elements are
+  /// hashed in parallel and their bits partitioned by region of the bit
+  /// vector, so that each thread sets bits only in its own regions.
+  /// @param first A random-access iterator to the first element.
+  /// @param last A random-access iterator one past the last element.
+  /// @param threads The number of threads.
+  /// @pre `threads > 0`
+  template <typename Iterator>
+  void add(Iterator first, Iterator last, size_t threads)
+  {
+    bulk_add([=](size_t i) { return wrap(first[i]); }, last - first, threads);
+  }
+
+  /// Checks whether another filter can be combined with this one, i.e.,
+  /// whether both have the same size, partitioning, and hasher. The hashers
+  /// are compared by their fingerprints, recorded at construction, which
+  /// cover the number of hash functions, the seeds, and the hashing mode.
+  /// @param other The other Bloom filter.
+  /// @return `true` iff the filters are compatible.
+  bool compatible(basic_bloom_filter const& other) const;
+
+  /// Adds the elements of another filter in place by OR-ing the bit vectors.
+  /// @param other The other Bloom filter.
+  /// @throws std::invalid_argument if the filters are not ::compatible.
+  void merge(basic_bloom_filter const& other);
+
+  /// Intersects this filter with another filter in place by AND-ing the bit
+  /// vectors. The result contains all common elements, and may report more
+  /// false positives than a filter built from the common elements alone.
+  /// @param other The other Bloom filter.
+  /// @throws std::invalid_argument if the filters are not ::compatible.
+  void intersect(basic_bloom_filter const& other);
+
   /// Removes an object from the Bloom filter.
   /// May introduce false negatives because the bitvector indices of the object
   /// to remove may be shared with other objects.
@@ -81,6 +145,37 @@ public:
   /// @param o The object to remove.
   void remove(object const& o);
 
+  /// Estimates the number of distinct elements added with the estimator of
+  /// Swamidass and Baldi, @f$n^* = -\frac{m}{k} \ln(1 - \frac{X}{m})@f$,
+  /// where *X* is the number of 1-bits.
+  /// @return The estimated cardinality, or infinity if all bits are set.
+  double estimated_cardinality() const;
+
+  /// Estimates the number of distinct elements in the union of this filter
+  /// and another filter, without materializing the union.
+  /// @param other The other Bloom filter.
+  /// @return The estimated cardinality of the union.
+  /// @throws std::invalid_argument if the filters are not ::compatible.
+  double estimated_union(basic_bloom_filter const& other) const;
+
+  /// Estimates the number of distinct elements in the intersection of this
+  /// filter and another filter as @f$n^*_A + n^*_B - n^*_{A \cup B}@f$,
+  /// without materializing the intersection.
+  /// @param other The other Bloom filter.
+  /// @return The estimated cardinality of the intersection.
+  /// @throws std::invalid_argument if the filters are not ::compatible.
+  double estimated_intersection(basic_bloom_filter const& other) const;
+
+  /// Retrieves a snapshot of the filter's health. The number of 1-bits is
+  /// maintained incrementally, so the snapshot does not scan the bit vector.
+  /// @return The current metrics.
+  filter_metrics metrics() const;
+
+  /// Serializes the bit vector together with the descriptor and the
+  /// fingerprint of the hasher.
+  /// @param out The stream to write to.
+  void save(std::ostream& out) const;
+
   /// Swaps two basic Bloom filters.
   /// @param other The other basic Bloom filter.
   void swap(basic_bloom_filter& other);
@@ -91,10 +186,46 @@ public:
   /// Returns the hasher of the Bloom filter.
   hasher const& hasher_function() const;
 
+  /// Checks whether the bit vector is partitioned per hash function.
+  bool partitioned() const;
+
+  /// Describes the hasher and the index mapping of the filter.
+  /// @return The descriptor of the hasher, with the mapping of the filter.
+  hasher_descriptor descriptor() const;
+
+  /// Maps digests to bit positions in place, e.g., to probe the storage of
+  /// a filter with the digests of its hasher.
+  /// @param digests The digests of an object.
+  /// @param cells The number of cells in the bit vector.
+  /// @param partition Whether the bit vector is partitioned.
+  static void map_indices(std::vector<size_t>& digests, size_t cells,
+                          bool partition);
+
+protected:
+  /// Maps an object to the indices in the underlying bit vector.
+  /// @param o The object to map.
+  /// @return The bit positions corresponding to the digests of *o*.
+  std::vector<size_t> find_indices(object const& o) const;
+
+  /// Retrieves the number of hash functions.
+  size_t hash_count() const;
+
 private:
+  /// Deserializes a filter from serialized bytes.
+  /// @param h The hasher to use, or `nullptr` to rebuild it.
+  static basic_bloom_filter deserialize(void const* data, size_t size,
+                                        hasher const* h);
+
+  /// Adds elements with ::bulk_update.
+  void bulk_add(std::function<object(size_t)> const& element, size_t n,
+                size_t threads);
+
   hasher hasher_;
+  uint64_t fingerprint_ = 0; ///< The ::fingerprint of the hasher.
   bitvector bits_;
   bool partition_;
+  size_t ones_ = 0;
+  event_counters events_;
 };
 
 } // namespace bf
@@ -0,0 +1,91 @@
+#ifndef BF_BLOOM_FILTER_BITSLICED_HPP
+#define BF_BLOOM_FILTER_BITSLICED_HPP
+
+#include <cstdint>
+#include <vector>
+#include <bf/bitvector.hpp>
+#include <bf/bloom_filter/basic.hpp>
+
+namespace bf {
+
+/// A bit-sliced index over many basic Bloom filters of identical geometry.
+///
+/// The index stores the filters transposed: for each of the *m* cell
+/// positions, a row holds one bit per filter. A query ANDs the *k* rows of
+/// an element, which yields the set of filters that may contain the element
+/// with *k* sequential scans over @f$N / 64@f$ words instead of *N*
+/// lookups with *k* random accesses each.
+///
+/// Reference: Faloutsos and Christodoulakis, "Signature Files: An Access
+/// Method for Documents and Its Analytical Performance Evaluation", 1984.
+class bitsliced_index
+{
+public:
+  /// Constructs an empty index.
+  ///
+  /// @param h The hasher that all filters use.
+  ///
+  /// @param cells The number of cells of each filter.
+  ///
+  /// @param partition Whether the filters partition their bit vectors.
+  bitsliced_index(hasher h, size_t cells, bool partition = false);
+
+  /// Constructs an empty index with the geometry of a given filter.
+  /// @param prototype The filter whose hasher and size to use.
+  explicit bitsliced_index(basic_bloom_filter const& prototype);
+
+  /// Appends a filter to the index.
+  /// @param filter The filter to append.
+  /// @return The position of *filter* in the candidate sets.
+  /// @throws std::invalid_argument if the geometry of *filter* differs.
+  /// @pre *filter* uses the same hash functions as the index.
+  size_t add(basic_bloom_filter const& filter);
+
+  /// Adds an element to an indexed filter.
+  /// @param filter The position of the filter.
+  /// @param o The object to add.
+  /// @pre `filter < size()`
+  void add(size_t filter, object const& o);
+
+  template <typename T>
+  void add(size_t filter, T const& x)
+  {
+    add(filter, wrap(x));
+  }
+
+  /// Finds the filters that may contain an element.
+  /// @param o The object to query.
+  /// @return A bit vector of `size()` bits where bit *i* is set iff filter
+  /// *i* reports *o*.
+  bitvector lookup(object const& o) const;
+
+  template <typename T>
+  bitvector lookup(T const& x) const
+  {
+    return lookup(wrap(x));
+  }
+
+  /// Removes all filters.
+  void clear();
+
+  /// Retrieves the number of indexed filters.
+  size_t size() const;
+
+  /// Retrieves the number of cells of each filter.
+  size_t cells() const;
+
+private:
+  /// Ensures that each row has room for a given number of filters.
+  void reserve(size_t filters);
+
+  hasher hasher_;
+  size_t cells_;
+  bool partition_;
+  size_t size_ = 0;
+  size_t stride_ = 0; ///< The number of words per row.
+  std::vector<uint64_t> rows_;
+};
+
+} // namespace bf
+
+#endif
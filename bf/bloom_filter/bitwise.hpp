@@ -22,6 +22,9 @@ public:
   virtual size_t lookup(object const& o) const override;
   virtual void clear() override;
 
+  /// Retrieves the number of bits of all levels.
+  size_t bits() const;
+
 private:
   /// Appends a new level.
   /// @post `levels_.size() += 1`
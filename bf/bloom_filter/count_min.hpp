@@ -0,0 +1,175 @@
+#ifndef BF_BLOOM_FILTER_COUNT_MIN_HPP
+#define BF_BLOOM_FILTER_COUNT_MIN_HPP
+
+#include <string>
+#include <utility>
+#include <vector>
+#include <bf/bloom_filter.hpp>
+#include <bf/counter_vector.hpp>
+#include <bf/hash.hpp>
+
+namespace bf {
+
+/// A count-min sketch.
+///
+/// The sketch consists of *d* rows of *w* counters each, with one hash
+/// function per row. An update increments one counter per row and a point
+/// query returns the minimum over the *d* counters of an element. Unlike a
+/// spectral Bloom filter, rows do not share counters, which yields the
+/// following guarantee: with @f$w = \lceil e / \epsilon \rceil@f$ and
+/// @f$d = \lceil \ln(1 / \delta) \rceil@f$, the estimate @f$\hat{a}@f$ of an
+/// element with true frequency @f$a@f$ satisfies @f$a \le \hat{a}@f$ and,
+/// with probability at least @f$1 - \delta@f$,
+/// @f$\hat{a} \le a + \epsilon N@f$, where *N* is the sum of all updates.
+///
+/// With *conservative update*, an update raises each counter only as far as
+/// necessary for the new minimum, which preserves the guarantee while
+/// reducing overestimation considerably in practice.
+///
+/// Counters saturate at their maximum value instead of wrapping around.
+class count_min_sketch : public bloom_filter
+{
+public:
+  /// Computes the number of counters per row for a given error factor.
+  /// @param epsilon The additive error as a fraction of the stream size.
+  /// @return @f$\lceil e / \epsilon \rceil@f$.
+  static size_t width(double epsilon);
+
+  /// Computes the number of rows for a given failure probability.
+  /// @param delta The probability that the error exceeds the bound.
+  /// @return @f$\lceil \ln(1 / \delta) \rceil@f$.
+  static size_t depth(double delta);
+
+  /// Constructs a count-min sketch. Use ::width and ::depth to derive the
+  /// dimensions from error bounds.
+  ///
+  /// @param width The number of counters per row.
+  ///
+  /// @param depth The number of rows.
+  ///
+  /// @param counter_width The number of bits per counter.
+  ///
+  /// @param seed The initial seed used to construct the hash functions.
+  ///
+  /// @param conservative Whether to use conservative update.
+  ///
+  /// @pre `width > 0 && depth > 0 && 0 < counter_width <= 64`
+  count_min_sketch(size_t width, size_t depth, size_t counter_width = 32,
+                   size_t seed = 0, bool conservative = true);
+
+  count_min_sketch(count_min_sketch&&) = default;
+
+  using bloom_filter::add;
+  using bloom_filter::lookup;
+
+  virtual void add(object const& o) override;
+
+  /// Adds an element multiple times.
+  /// @param o The object to add.
+  /// @param count The number of occurrences of *o*.
+  void add(object const& o, size_t count);
+
+  template <typename T>
+  void add(T const& x, size_t count)
+  {
+    add(wrap(x), count);
+  }
+
+  /// Adds a batch of elements. The implementation hashes a group of
+  /// elements and prefetches their counters before updating them.
+  /// @param os The objects to add.
+  virtual void add(std::vector<object> const& os) override;
+
+  virtual size_t lookup(object const& o) const override;
+
+  virtual void clear() override;
+
+  /// Adds the counters of another sketch to this sketch. The result
+  /// equals the sketch of the concatenated streams, except that
+  /// conservative update yields a weaker but still valid upper bound.
+  /// @param other The sketch to merge.
+  /// @pre Both sketches have the same dimensions, counter width, and seed.
+  void merge(count_min_sketch const& other);
+
+  /// Tracks the *k* elements with the highest estimated frequency. Only
+  /// elements added afterwards are candidates.
+  /// @param k The number of heavy hitters to track.
+  void track(size_t k);
+
+  /// Retrieves the tracked heavy hitters.
+  /// @return The raw bytes of the elements along with their frequency
+  /// estimate, sorted by decreasing estimate.
+  std::vector<std::pair<std::string, size_t>> heavy_hitters() const;
+
+  /// Retrieves the sum of all updates, i.e., the stream size *N*.
+  size_t total() const;
+
+  /// Retrieves the number of counters per row.
+  size_t width() const;
+
+  /// Retrieves the number of rows.
+  size_t depth() const;
+
+protected:
+  /// Maps an object to one counter index per row.
+  std::vector<size_t> find_indices(object const& o) const;
+
+  /// Computes the point query for precomputed indices.
+  size_t find_minimum(std::vector<size_t> const& indices) const;
+
+  /// Applies an update for precomputed indices.
+  void update(object const& o, std::vector<size_t> const& indices,
+              size_t count);
+
+  hasher hasher_;
+  std::vector<counter_vector> rows_;
+  size_t seed_;
+  bool conservative_;
+  size_t total_ = 0;
+
+private:
+  typedef std::pair<size_t, std::string> hitter;
+
+  /// Offers an element to the heavy hitters heap.
+  void offer(std::string key, size_t estimate);
+
+  size_t k_ = 0;
+  std::vector<hitter> heap_; ///< A min-heap of tracked elements.
+};
+
+/// A count-mean-min sketch.
+///
+/// The sketch has the structure of a count-min sketch without conservative
+/// update, but subtracts the expected noise from each counter: a counter
+/// with value *c* in a row of *w* counters estimates the frequency as
+/// @f$c - (N - c) / (w - 1)@f$. A point query returns the median of these
+/// row estimates, bounded above by the count-min estimate. The result is
+/// unbiased for skewed as well as uniform streams, but may underestimate.
+class count_mean_min_sketch : public count_min_sketch
+{
+public:
+  /// Constructs a count-mean-min sketch.
+  ///
+  /// @param width The number of counters per row.
+  ///
+  /// @param depth The number of rows.
+  ///
+  /// @param counter_width The number of bits per counter.
+  ///
+  /// @param seed The initial seed used to construct the hash functions.
+  ///
+  /// @pre `width > 1 && depth > 0 && 0 < counter_width <= 64`
+  count_mean_min_sketch(size_t width, size_t depth, size_t counter_width = 32,
+                        size_t seed = 0);
+
+  count_mean_min_sketch(count_mean_min_sketch&&) = default;
+
+  using count_min_sketch::add;
+  using count_min_sketch::lookup;
+
+  virtual size_t lookup(object const& o) const override;
+};
+
+} // namespace bf
+
+#endif
@@ -1,9 +1,13 @@
 #ifndef BF_BLOOM_FILTER_COUNTING_HPP
 #define BF_BLOOM_FILTER_COUNTING_HPP
 
+#include <functional>
+#include <iosfwd>
+#include <string>
 #include <bf/counter_vector.hpp>
 #include <bf/bloom_filter.hpp>
 #include <bf/hash.hpp>
+#include <bf/metrics.hpp>
 
 namespace bf {
 
@@ -25,9 +29,36 @@ public:
   counting_bloom_filter(hasher h, size_t cells, size_t width,
                         bool partition = false);
 
+  /// Constructs a counting Bloom filter given a hasher and counters.
+  /// @param h The hasher.
+  /// @param cells The underlying counter vector.
+  /// @param partition Whether the counters are partitioned per hash function.
+  counting_bloom_filter(hasher h, counter_vector cells,
+                        bool partition = false);
+
   /// Move-constructs a counting Bloom filter.
   counting_bloom_filter(counting_bloom_filter&&) = default;
 
+  /// Loads a filter from a stream and rebuilds its hasher from the
+  /// descriptor that ::save records.
+  /// @param in The stream to read from.
+  /// @return The deserialized filter.
+  /// @throws std::runtime_error if *in* does not contain a valid filter or
+  /// the filter has a custom hasher.
+  static counting_bloom_filter load(std::istream& in);
+
+  /// Loads a filter from a file by mapping it into memory.
+  /// @param filename The file written by ::save.
+  /// @return The deserialized filter.
+  /// @throws std::runtime_error if the file does not contain a valid filter
+  /// or the filter has a custom hasher.
+  static counting_bloom_filter load(std::string const& filename);
+
+  /// Serializes the counters together with the descriptor and the
+  /// fingerprint of the hasher.
+  /// @param out The stream to write to.
+  void save(std::ostream& out) const;
+
   using bloom_filter::add;
   using bloom_filter::lookup;
 
@@ -35,6 +66,20 @@ public:
   virtual size_t lookup(object const& o) const override;
   virtual void clear() override;
 
+  /// Adds a range of elements using multiple threads. The elements are
+  /// hashed in parallel and their cells partitioned by region of the
+  /// counter vector, so that each thread increments counters only in its
+  /// own regions.
+  /// @param first A random-access iterator to the first element.
+  /// @param last A random-access iterator one past the last element.
+  /// @param threads The number of threads.
+  /// @pre `threads > 0`
+  template <typename Iterator>
+  void add(Iterator first, Iterator last, size_t threads)
+  {
+    bulk_add([=](size_t i) { return wrap(first[i]); }, last - first, threads);
+  }
+
   /// Removes an element.
   /// @param o The object whose cells to decrement by 1.
   void remove(object const& o);
@@ -45,6 +90,44 @@ public:
     remove(wrap(x));
   }
 
+  /// Checks whether another filter can be combined with this one, i.e.,
+  /// whether both have the same number of cells, counter width,
+  /// partitioning, and hasher fingerprint.
+  /// @param other The other counting Bloom filter.
+  /// @return `true` iff the filters are compatible.
+  bool compatible(counting_bloom_filter const& other) const;
+
+  /// Adds the elements of another filter in place by adding the counters,
+  /// saturating at the maximum counter value.
+  /// @param other The other counting Bloom filter.
+  /// @throws std::invalid_argument if the filters are not ::compatible.
+  void merge(counting_bloom_filter const& other);
+
+  /// Intersects this filter with another filter in place by taking the
+  /// minimum of each pair of counters.
+  /// @param other The other counting Bloom filter.
+  /// @throws std::invalid_argument if the filters are not ::compatible.
+  void intersect(counting_bloom_filter const& other);
+
+  /// Retrieves a snapshot of the filter's health. The numbers of nonzero
+  /// and saturated counters are maintained incrementally, so the snapshot
+  /// does not scan the counters.
+  /// @return The current metrics.
+  filter_metrics metrics() const;
+
+  /// Returns the underlying counters.
+  counter_vector const& storage() const;
+
+  /// Returns the hasher.
+  hasher const& hasher_function() const;
+
+  /// Checks whether the counters are partitioned per hash function.
+  bool partitioned() const;
+
+  /// Describes the hasher and the index mapping of the filter.
+  /// @return The descriptor of the hasher, with the mapping of the filter.
+  hasher_descriptor descriptor() const;
+
 protected:
   /// Maps an object to the indices in the underlying counter vector.
   /// @param o The object to map.
@@ -67,18 +150,42 @@ protected:
   bool increment(std::vector<size_t> const& indices, size_t value = 1);
 
   /// Decrements a given set of indices in the underlying counter vector.
+  /// Counters smaller than *value* become 0.
   /// @param indices The indices to decrement.
   /// @return `true` iff no counter underflowed.
   bool decrement(std::vector<size_t> const& indices, size_t value = 1);
 
+  /// Decrements all nonzero counters in a range of cells by 1.
+  /// @param first The first cell.
+  /// @param last One past the last cell.
+  /// @pre `first <= last && last <= cells_.size()`
+  void decrement_range(size_t first, size_t last);
+
+  /// Sets a given set of indices to the maximum counter value. Unlike
+  /// ::increment, this records no overflows, because the counters reach
+  /// their maximum on purpose.
+  /// @param indices The indices to saturate.
+  void saturate(std::vector<size_t> const& indices);
+
+  /// Deserializes a filter from serialized bytes.
+  static counting_bloom_filter deserialize(void const* data, size_t size);
+
+  /// Adds elements with ::bulk_update.
+  void bulk_add(std::function<object(size_t)> const& element, size_t n,
+                size_t threads);
+
   /// Retrieves the counter for given cell index.
   /// @param index The index of the counter vector.
   /// @pre `index < cells.size()`
   size_t count(size_t index) const;
 
   hasher hasher_;
+  uint64_t fingerprint_; ///< The ::fingerprint of the hasher.
   counter_vector cells_;
   bool partition_;
+  size_t nonzero_ = 0;
+  size_t saturated_ = 0;
+  event_counters events_;
 };
 
 /// A spectral Bloom filter with minimum increase (MI) policy.
@@ -125,6 +232,9 @@ public:
   /// @param o The object whose cells to decrement by 1.
   void remove(object const& o);
 
+  /// Retrieves the number of counter bits of both Bloom filters.
+  size_t bits() const;
+
 private:
   counting_bloom_filter first_;
   counting_bloom_filter second_;
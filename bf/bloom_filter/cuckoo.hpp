@@ -0,0 +1,137 @@
+#ifndef BF_BLOOM_FILTER_CUCKOO_HPP
+#define BF_BLOOM_FILTER_CUCKOO_HPP
+
+#include <random>
+#include <utility>
+#include <bf/bloom_filter.hpp>
+#include <bf/counter_vector.hpp>
+#include <bf/hash.hpp>
+
+namespace bf {
+
+/// A cuckoo filter with 4-way buckets and partial-key cuckoo hashing.
+///
+/// Each element maps to a fingerprint and two candidate buckets, where the
+/// second bucket derives from the first bucket and the fingerprint alone.
+/// Hence a lookup touches at most two buckets (two cache lines) and, unlike
+/// a counting Bloom filter, removal only requires a single fingerprint per
+/// element.
+///
+/// If an insertion cannot find a free slot after a bounded number of
+/// kick-outs, the last evicted fingerprint moves into a small victim stash.
+class cuckoo_filter : public bloom_filter
+{
+public:
+  /// The number of fingerprints per bucket.
+  static constexpr size_t bucket_size = 4;
+
+  /// The maximum number of kick-outs per insertion.
+  static constexpr size_t max_kicks = 500;
+
+  /// The maximum number of entries in the victim stash.
+  static constexpr size_t stash_size = 4;
+
+  /// Computes the number of fingerprint bits required for a desired
+  /// false-positive rate, i.e., @f$\lceil \log_2(2b/\epsilon) \rceil@f$.
+  ///
+  /// @param fp The desired false-positive rate.
+  ///
+  /// @return The number of bits per fingerprint.
+  static size_t fingerprint_bits(double fp);
+
+  /// Computes the number of buckets to accommodate a given number of
+  /// elements at a load factor of 95%.
+  ///
+  /// @param capacity The maximum number of elements.
+  ///
+  /// @return The number of buckets, rounded up to a power of two.
+  static size_t buckets(size_t capacity);
+
+  /// Constructs a cuckoo filter.
+  ///
+  /// @param h The hash function that maps an object to bucket and
+  /// fingerprint.
+  ///
+  /// @param buckets The number of buckets.
+  ///
+  /// @param fingerprint_bits The number of bits per fingerprint.
+  ///
+  /// @param seed The seed of the PRNG to select kick-out victims.
+  ///
+  /// @pre `buckets` is a power of two and `0 < fingerprint_bits <= 32`
+  cuckoo_filter(hash_function h, size_t buckets, size_t fingerprint_bits,
+                size_t seed = 0);
+
+  /// Constructs a cuckoo filter from a desired false-positive rate and an
+  /// expected number of elements.
+  ///
+  /// @param fp The desired false-positive rate.
+  ///
+  /// @param capacity The maximum number of elements.
+  ///
+  /// @param seed The initial seed used to construct the hash function.
+  cuckoo_filter(double fp, size_t capacity, size_t seed = 0);
+
+  cuckoo_filter(cuckoo_filter&&) = default;
+
+  using bloom_filter::add;
+  using bloom_filter::lookup;
+
+  /// Adds an element to the cuckoo filter.
+  /// @param o The object to add.
+  /// @throws std::length_error if the filter (including the stash) is full.
+  virtual void add(object const& o) override;
+
+  /// Retrieves the number of matching fingerprints of an element.
+  /// @param o The object to query.
+  /// @return The number of times *o* has been added (modulo false positives).
+  virtual size_t lookup(object const& o) const override;
+
+  virtual void clear() override;
+
+  /// Removes one copy of an element.
+  /// @param o The object to remove.
+  /// @return `true` iff a matching fingerprint was found and removed.
+  bool remove(object const& o);
+
+  template <typename T>
+  bool remove(T const& x)
+  {
+    return remove(wrap(x));
+  }
+
+  /// Retrieves the number of stored fingerprints.
+  size_t size() const;
+
+  /// Retrieves the number of fingerprint slots, excluding the stash.
+  size_t slots() const;
+
+private:
+  /// Computes the primary bucket and fingerprint of an object.
+  std::pair<size_t, size_t> locate(object const& o) const;
+
+  /// Computes the alternate bucket from a bucket and a fingerprint.
+  size_t alternate(size_t bucket, size_t fingerprint) const;
+
+  /// Stores a fingerprint in a free slot of a bucket.
+  /// @return `true` iff the bucket had a free slot.
+  bool insert(size_t bucket, size_t fingerprint);
+
+  /// Removes one fingerprint from a bucket.
+  /// @return `true` iff the bucket contained the fingerprint.
+  bool erase(size_t bucket, size_t fingerprint);
+
+  /// Counts the occurrences of a fingerprint in a bucket.
+  size_t count(size_t bucket, size_t fingerprint) const;
+
+  hash_function hash_;
+  counter_vector slots_;
+  size_t mask_;
+  size_t size_ = 0;
+  std::vector<std::pair<size_t, size_t>> stash_;
+  std::minstd_rand prng_;
+};
+
+} // namespace bf
+
+#endif
@@ -0,0 +1,127 @@
+#ifndef BF_BLOOM_FILTER_EXPIRING_HPP
+#define BF_BLOOM_FILTER_EXPIRING_HPP
+
+#include <cstdint>
+#include <bf/bloom_filter.hpp>
+#include <bf/counter_vector.hpp>
+#include <bf/hash.hpp>
+
+namespace bf {
+
+/// A Bloom filter whose elements expire after a time-to-live (TTL).
+///
+/// Time advances in *generations* of a fixed resolution. Each cell stores
+/// a small generation stamp modulo @f$R = 2^w - 1@f$, where 0 marks an
+/// empty cell. Adding an element writes the current stamp into its cells,
+/// and a lookup reports the element iff all its cells carry a stamp at most
+/// *T* generations old, where *T* is the TTL in generations. An element thus
+/// expires between *ttl* and *ttl + resolution* time units after its last
+/// addition. The memory usage is fixed regardless of the event rate.
+///
+/// Because stamps wrap around, a stale stamp would eventually appear fresh
+/// again. To prevent this, the filter clears expired cells with a cursor
+/// that advances proportionally to the elapsed generations, such that it
+/// visits every cell at least once every @f$R - T - 2@f$ generations. With
+/// @f$T \le (R - 2) / 2@f$, this amortizes to at most two cell visits per
+/// cell and TTL.
+class expiring_bloom_filter : public bloom_filter
+{
+public:
+  /// Computes the minimum cell width for a TTL.
+  /// @param generations The TTL in generations.
+  /// @return The smallest width *w* with @f$T \le (2^w - 3) / 2@f$.
+  static size_t width(uint64_t generations);
+
+  /// Constructs an expiring Bloom filter.
+  ///
+  /// @param h The hasher.
+  ///
+  /// @param cells The number of cells.
+  ///
+  /// @param width The number of bits per cell.
+  ///
+  /// @param ttl The time-to-live of an element, in the units of *now*.
+  ///
+  /// @param resolution The length of a generation, in the units of *now*.
+  ///
+  /// @pre `cells > 0 && resolution > 0 && width >= width(ceil(ttl /
+  /// resolution))`
+  expiring_bloom_filter(hasher h, size_t cells, size_t width, uint64_t ttl,
+                        uint64_t resolution = 1);
+
+  expiring_bloom_filter(expiring_bloom_filter&&) = default;
+
+  using bloom_filter::add;
+  using bloom_filter::lookup;
+
+  /// Adds an element in the current generation.
+  /// @param o The object to add.
+  virtual void add(object const& o) override;
+
+  /// Advances the time and adds an element.
+  /// @param o The object to add.
+  /// @param now The current time.
+  void add(object const& o, uint64_t now);
+
+  template <typename T>
+  void add(T const& x, uint64_t now)
+  {
+    add(wrap(x), now);
+  }
+
+  /// Checks whether an element has been added within the TTL, relative to
+  /// the current generation.
+  /// @param o The object to query.
+  /// @return 1 if *o* may have been added within the TTL and 0 otherwise.
+  virtual size_t lookup(object const& o) const override;
+
+  /// Advances the time and checks whether an element has been added within
+  /// the TTL.
+  /// @param o The object to query.
+  /// @param now The current time.
+  /// @return 1 if *o* may have been added within the TTL and 0 otherwise.
+  size_t lookup(object const& o, uint64_t now);
+
+  template <typename T>
+  size_t lookup(T const& x, uint64_t now)
+  {
+    return lookup(wrap(x), now);
+  }
+
+  virtual void clear() override;
+
+  /// Advances the current generation. Time never moves backwards: earlier
+  /// times than the latest one have no effect. The sweep for all elapsed
+  /// generations happens at once and visits each cell at most once.
+  /// @param now The current time.
+  void advance(uint64_t now);
+
+  /// Retrieves the current generation.
+  uint64_t generation() const;
+
+  /// Retrieves the TTL in generations.
+  uint64_t ttl() const;
+
+private:
+  /// Computes the age of a nonzero stamp in generations.
+  uint64_t age(size_t stamp) const;
+
+  /// Clears cells at the sweep cursor that are expired after advancing by
+  /// *elapsed* generations. Since every stamp is less than @f$R - 1@f$
+  /// generations old before the advance, its age before the advance plus
+  /// *elapsed* is exact.
+  void sweep(size_t n, uint64_t elapsed);
+
+  hasher hasher_;
+  counter_vector cells_;
+  uint64_t ttl_;
+  uint64_t resolution_;
+  uint64_t generation_ = 0;
+  size_t stamp_ = 1;   ///< The stamp of the current generation.
+  size_t cursor_ = 0;  ///< The next cell to sweep.
+  uint64_t credit_ = 0; ///< Sweep progress not yet converted to cells.
+};
+
+} // namespace bf
+
+#endif
@@ -0,0 +1,117 @@
+#ifndef BF_BLOOM_FILTER_FUSE_HPP
+#define BF_BLOOM_FILTER_FUSE_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include <bf/bloom_filter.hpp>
+#include <bf/fuse_graph.hpp>
+#include <bf/hash.hpp>
+
+namespace bf {
+
+/// A static binary fuse filter.
+///
+/// The filter stores one fingerprint per slot in an array of
+/// @f$\approx 1.125n@f$ slots, such that the fingerprints at the three slots
+/// of a key XOR to the fingerprint of the key. The three slots lie in
+/// consecutive segments, which makes construction cache-friendly. Lookups
+/// require three memory accesses.
+///
+/// With 8-bit fingerprints the filter uses about 9 bits per key at a
+/// false-positive rate of @f$2^{-8} \approx 0.4\%@f$.
+///
+/// The filter is immutable: it must be constructed from the complete key set
+/// and rejects subsequent additions.
+class binary_fuse_filter : public bloom_filter
+{
+public:
+  /// Constructs a binary fuse filter from a range of keys.
+  ///
+  /// @param first An iterator to the first key.
+  ///
+  /// @param last An iterator one past the last key.
+  ///
+  /// @param fingerprint_bits The number of bits per fingerprint, either 8 or
+  /// 16.
+  ///
+  /// @param seed The initial seed used to construct the hash function.
+  ///
+  /// @throws std::runtime_error if construction fails, which happens with
+  /// negligible probability.
+  template <typename Iterator>
+  binary_fuse_filter(Iterator first, Iterator last,
+                     size_t fingerprint_bits = 8, size_t seed = 0)
+    : binary_fuse_filter(fingerprint_bits, seed)
+  {
+    std::vector<uint64_t> digests;
+    for (; first != last; ++first)
+      digests.push_back(hash_(wrap(*first)));
+    build(std::move(digests));
+  }
+
+  binary_fuse_filter(binary_fuse_filter&&) = default;
+
+  /// Loads a filter from a stream.
+  /// @param in The stream to read from.
+  /// @return The deserialized filter.
+  /// @throws std::runtime_error if *in* does not contain a valid filter.
+  static binary_fuse_filter load(std::istream& in);
+
+  /// Loads a filter from a file by mapping it into memory. The fingerprints
+  /// are not copied but referenced in the mapping.
+  /// @param filename The file written by ::save.
+  /// @return The deserialized filter.
+  /// @throws std::runtime_error if the file does not contain a valid filter.
+  static binary_fuse_filter load(std::string const& filename);
+
+  using bloom_filter::add;
+  using bloom_filter::lookup;
+
+  /// Rejects additions because the filter is immutable.
+  /// @throws std::logic_error always.
+  virtual void add(object const& o) override;
+
+  virtual size_t lookup(object const& o) const override;
+
+  /// Removes all keys.
+  virtual void clear() override;
+
+  /// Serializes the filter.
+  /// @param out The stream to write to.
+  void save(std::ostream& out) const;
+
+  /// Retrieves the number of keys the filter was constructed from.
+  size_t size() const;
+
+  /// Retrieves the number of fingerprint slots.
+  size_t slots() const;
+
+  /// Retrieves the number of bits per fingerprint.
+  size_t fingerprint_bits() const;
+
+private:
+  binary_fuse_filter(size_t fingerprint_bits, size_t seed);
+
+  /// Solves the XOR system for a set of key digests.
+  void build(std::vector<uint64_t> digests);
+
+  /// Deserializes a filter from serialized bytes.
+  static binary_fuse_filter load(void const* data, size_t size,
+                                 std::shared_ptr<void const> owner);
+
+  size_t seed_;
+  default_hash_function hash_;
+  size_t width_;
+  size_t size_ = 0;
+  uint64_t mix_ = 0;
+  fuse_graph graph_;
+  std::shared_ptr<void const> owner_;
+  unsigned char const* fingerprints_ = nullptr;
+};
+
+} // namespace bf
+
+#endif
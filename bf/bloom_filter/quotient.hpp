@@ -0,0 +1,172 @@
+#ifndef BF_BLOOM_FILTER_QUOTIENT_HPP
+#define BF_BLOOM_FILTER_QUOTIENT_HPP
+
+#include <bf/bloom_filter.hpp>
+#include <bf/counter_vector.hpp>
+#include <bf/hash.hpp>
+
+namespace bf {
+
+/// A counting quotient filter.
+///
+/// The filter splits a *p*-bit fingerprint into a *q*-bit quotient, which
+/// selects a canonical slot, and an *r*-bit remainder, which is stored in a
+/// run of slots near the canonical slot. Runs are kept sorted and contiguous
+/// so that a lookup scans a handful of adjacent slots instead of probing *k*
+/// random cells.
+///
+/// Multiplicities use a variable-length encoding: an element with count *c*
+/// occupies one slot for its remainder, followed by as many counter slots as
+/// needed to represent `c - 1` in base @f$2^r@f$. Hence, singletons cost one
+/// slot and frequent elements grow logarithmically.
+///
+/// When the table fills up, it doubles by moving one bit from each remainder
+/// to the quotient. The fingerprint length `q + r` stays fixed, so the filter
+/// holds at most about @f$0.9 \cdot 2^{q+r-1}@f$ slots, after which adding
+/// throws `std::length_error`.
+class counting_quotient_filter : public bloom_filter
+{
+public:
+  /// Constructs a counting quotient filter.
+  ///
+  /// @param h The hash function to compute fingerprints.
+  ///
+  /// @param quotient_bits The number of quotient bits *q*, which yields
+  /// @f$2^q@f$ canonical slots.
+  ///
+  /// @param remainder_bits The number of remainder bits *r*.
+  ///
+  /// @pre `quotient_bits > 0 && remainder_bits > 0 &&
+  ///       quotient_bits + remainder_bits <= 64 && remainder_bits <= 60`
+  counting_quotient_filter(hash_function h, size_t quotient_bits,
+                           size_t remainder_bits);
+
+  /// Constructs a counting quotient filter from a desired false-positive
+  /// rate and an expected number of distinct elements.
+  ///
+  /// @param fp The desired false-positive rate.
+  ///
+  /// @param capacity The expected number of distinct elements.
+  ///
+  /// @param seed The initial seed used to construct the hash function.
+  counting_quotient_filter(double fp, size_t capacity, size_t seed = 0);
+
+  counting_quotient_filter(counting_quotient_filter&&) = default;
+
+  using bloom_filter::add;
+  using bloom_filter::lookup;
+
+  /// Adds an element.
+  /// @param o The object to add.
+  /// @throws std::length_error if the table is full and cannot grow.
+  virtual void add(object const& o) override;
+
+  /// Adds multiple copies of an element.
+  /// @param o The object to add.
+  /// @param count The number of copies to add.
+  /// @throws std::length_error if the table is full and cannot grow.
+  /// @pre `count > 0`
+  void add(object const& o, size_t count);
+
+  template <typename T>
+  void add(T const& x, size_t count)
+  {
+    add(wrap(x), count);
+  }
+
+  virtual size_t lookup(object const& o) const override;
+  virtual void clear() override;
+
+  /// Removes copies of an element.
+  /// @param o The object to remove.
+  /// @param count The number of copies to remove.
+  /// @return `true` iff the filter contained *o*.
+  bool remove(object const& o, size_t count = 1);
+
+  template <typename T>
+  bool remove(T const& x, size_t count = 1)
+  {
+    return remove(wrap(x), count);
+  }
+
+  /// Merges another filter into this one by scanning both tables
+  /// sequentially.
+  /// @param other The filter to merge.
+  /// @pre Both filters use the same hash function and fingerprint length
+  ///      `quotient_bits() + remainder_bits()`.
+  void merge(counting_quotient_filter const& other);
+
+  /// Doubles the number of canonical slots. Each remainder gives up its most
+  /// significant bit to the quotient, which doubles the false-positive rate.
+  /// @throws std::length_error if `remainder_bits() == 1`, leaving the filter
+  /// unchanged.
+  void resize();
+
+  /// Retrieves the number of quotient bits.
+  size_t quotient_bits() const;
+
+  /// Retrieves the number of remainder bits.
+  size_t remainder_bits() const;
+
+  /// Retrieves the number of occupied slots.
+  size_t size() const;
+
+  /// Retrieves the total number of slots, including overflow slots.
+  size_t slots() const;
+
+  /// Retrieves the number of bits per slot, i.e., the remainder bits plus
+  /// the metadata bits.
+  size_t slot_bits() const;
+
+private:
+  struct entry
+  {
+    size_t quotient;
+    size_t remainder;
+    size_t count;
+  };
+
+  /// Computes the number of counter slots needed to represent *count*.
+  size_t digits(size_t count) const;
+
+  /// Computes quotient and remainder of an object.
+  entry locate(object const& o) const;
+
+  bool empty(size_t slot) const;
+
+  /// Finds the first slot of the cluster containing a non-empty slot.
+  size_t cluster_start(size_t slot) const;
+
+  /// Decodes all entries from a cluster start until the next empty slot.
+  /// @return The index of the first empty slot after *start*.
+  size_t decode(size_t start, std::vector<entry>& entries) const;
+
+  /// Decodes all entries in the filter in fingerprint order.
+  std::vector<entry> decode() const;
+
+  /// Computes the end of the region required to lay out entries from a
+  /// given start.
+  size_t layout(size_t start, std::vector<entry> const& entries) const;
+
+  /// Writes sorted entries starting at a given slot and clears all slots
+  /// after them up to a given end.
+  void encode(size_t start, size_t end, std::vector<entry> const& entries);
+
+  /// Applies a modification to the entries in the region around a quotient.
+  /// @return `false` iff the modified region does not fit into the table.
+  template <typename F>
+  bool update(size_t quotient, F f);
+
+  /// Reinitializes the table to hold all entries with a given quotient size.
+  void rebuild(size_t quotient_bits, std::vector<entry> const& entries);
+
+  hash_function hash_;
+  size_t q_;
+  size_t r_;
+  size_t used_ = 0;
+  counter_vector slots_;
+};
+
+} // namespace bf
+
+#endif
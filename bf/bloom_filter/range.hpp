@@ -0,0 +1,99 @@
+#ifndef BF_BLOOM_FILTER_RANGE_HPP
+#define BF_BLOOM_FILTER_RANGE_HPP
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include <bf/bloom_filter/basic.hpp>
+
+namespace bf {
+
+/// A range filter over 64-bit integer keys.
+///
+/// The filter keeps one basic Bloom filter per level *l* that stores the
+/// dyadic prefixes @f$x \gg l@f$ of all keys. A range query decomposes the
+/// range into at most two maximal dyadic intervals per level and probes
+/// their prefixes. A positive probe at level *l > 0* descends into the two
+/// halves of the interval, so that a query only reports a range if some
+/// full-length key in it passes the bottom level. Hence there are no false
+/// negatives, and a false positive requires a chain of false positives down
+/// to the bottom level.
+///
+/// The number of levels follows from the maximum range length *R*; ranges
+/// longer than *R* remain correct but cost time linear in
+/// @f$\text{length} / R@f$. Each level has a false-positive rate of *fp / 4*,
+/// which bounds the false-positive rate of an empty range by about *fp*.
+///
+/// Reference: Luo, Chatterjee, Ketsetsidis, Dayan, Qin, and Idreos,
+/// "Rosetta: A Robust Space-Time Optimized Range Filter for Key-Value
+/// Stores", 2020.
+class range_bloom_filter
+{
+public:
+  /// An inclusive range of keys.
+  typedef std::pair<uint64_t, uint64_t> range;
+
+  /// Constructs a range filter.
+  ///
+  /// @param fp The desired false-positive rate of range queries up to
+  /// *max_range* keys.
+  ///
+  /// @param capacity The maximum number of keys.
+  ///
+  /// @param max_range The maximum length of a range query.
+  ///
+  /// @param seed The initial seed used to construct the hash functions.
+  ///
+  /// @pre `0 < fp < 1 && capacity > 0 && max_range > 0`
+  range_bloom_filter(double fp, size_t capacity, uint64_t max_range,
+                     size_t seed = 0);
+
+  range_bloom_filter(range_bloom_filter&&) = default;
+
+  /// Adds a key.
+  /// @param key The key to add.
+  void add(uint64_t key);
+
+  /// Checks whether a key may exist.
+  /// @param key The key to query.
+  /// @return 1 if *key* may exist and 0 otherwise.
+  size_t lookup(uint64_t key) const;
+
+  /// Checks whether any key may fall into a range.
+  /// @param lo The first key of the range.
+  /// @param hi The last key of the range.
+  /// @return 1 if some key in *[lo, hi]* may exist and 0 otherwise.
+  /// @pre `lo <= hi`
+  size_t lookup_range(uint64_t lo, uint64_t hi) const;
+
+  /// Checks a batch of ranges. The implementation decomposes a group of
+  /// ranges and prefetches the bits of all their top-level probes before
+  /// evaluating them, so that cache misses overlap.
+  /// @param ranges The ranges to query.
+  /// @return The results of ::lookup_range for each range.
+  std::vector<size_t> lookup_range(std::vector<range> const& ranges) const;
+
+  /// Removes all keys.
+  void clear();
+
+  /// Retrieves the number of levels.
+  size_t levels() const;
+
+private:
+  /// Computes the level of the maximal dyadic interval that starts at a
+  /// given key and ends at most at the end of a range.
+  size_t step(uint64_t x, uint64_t hi) const;
+
+  /// Checks whether a full-length key in the halves of a dyadic interval
+  /// may exist.
+  bool descend(size_t level, uint64_t prefix) const;
+
+  /// Checks whether a full-length key in a dyadic interval may exist.
+  bool probe(size_t level, uint64_t prefix) const;
+
+  std::vector<basic_bloom_filter> levels_;
+};
+
+} // namespace bf
+
+#endif
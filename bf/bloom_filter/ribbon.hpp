@@ -0,0 +1,129 @@
+#ifndef BF_BLOOM_FILTER_RIBBON_HPP
+#define BF_BLOOM_FILTER_RIBBON_HPP
+
+#include <cstdint>
+#include <vector>
+#include <bf/bloom_filter.hpp>
+#include <bf/hash.hpp>
+
+namespace bf {
+
+/// A static homogeneous Ribbon filter.
+///
+/// Each key contributes one linear equation over GF(2) whose 64 coefficients
+/// start at a key-dependent slot. The equations form a banded system, which
+/// construction solves in a streaming fashion with on-the-fly Gaussian
+/// elimination followed by back-substitution. A lookup multiplies the
+/// coefficients of a key with the solution and reports membership iff all
+/// *r* result bits are zero.
+///
+/// In the homogeneous variant every equation has a zero right-hand side, so
+/// construction never fails and free variables take random values. The
+/// filter then uses @f$r(1 + \epsilon)@f$ bits per key for a false-positive
+/// rate of about @f$2^{-r}@f$, where the information-theoretic bound is *r*
+/// bits per key.
+///
+/// Large key sets are split into independent partitions, which can be solved
+/// in parallel.
+class ribbon_filter : public bloom_filter
+{
+public:
+  /// The number of coefficients per equation.
+  static constexpr size_t band_width = 64;
+
+  /// The number of keys per partition.
+  static constexpr size_t partition_size = 1 << 18;
+
+  /// The fraction of slots in excess of the number of keys.
+  static constexpr double overhead = 0.08;
+
+  /// Computes the number of fingerprint bits for a desired false-positive
+  /// rate.
+  /// @param fp The desired false-positive rate.
+  /// @return The number of bits *r* such that @f$2^{-r} \le fp@f$.
+  static size_t fingerprint_bits(double fp);
+
+  /// Computes the space requirement of a Ribbon filter.
+  /// @param fingerprint_bits The number of fingerprint bits.
+  /// @return The number of bits per key.
+  static double bits_per_key(size_t fingerprint_bits);
+
+  /// Constructs a Ribbon filter from a range of keys.
+  ///
+  /// @param first An iterator to the first key.
+  ///
+  /// @param last An iterator one past the last key.
+  ///
+  /// @param fingerprint_bits The number of result bits per equation.
+  ///
+  /// @param threads The number of threads that solve partitions.
+  ///
+  /// @param seed The initial seed used to construct the hash function.
+  ///
+  /// @pre `0 < fingerprint_bits <= 32 && threads > 0`
+  template <typename Iterator>
+  ribbon_filter(Iterator first, Iterator last, size_t fingerprint_bits = 8,
+                size_t threads = 1, size_t seed = 0)
+    : ribbon_filter(fingerprint_bits, seed)
+  {
+    std::vector<uint64_t> digests;
+    for (; first != last; ++first)
+      digests.push_back(hash_(wrap(*first)));
+    build(digests, threads);
+  }
+
+  ribbon_filter(ribbon_filter&&) = default;
+
+  using bloom_filter::add;
+  using bloom_filter::lookup;
+
+  /// Rejects additions because the filter is immutable.
+  /// @throws std::logic_error always.
+  virtual void add(object const& o) override;
+
+  virtual size_t lookup(object const& o) const override;
+
+  /// Removes all keys.
+  virtual void clear() override;
+
+  /// Retrieves the number of keys the filter was constructed from.
+  size_t size() const;
+
+  /// Retrieves the number of solution slots over all partitions.
+  size_t slots() const;
+
+  /// Retrieves the number of partitions.
+  size_t partitions() const;
+
+  /// Retrieves the number of fingerprint bits.
+  size_t fingerprint_bits() const;
+
+private:
+  struct partition
+  {
+    size_t offset; ///< The first word of the partition's solution.
+    size_t slots;  ///< The number of slots (variables) in the partition.
+  };
+
+  ribbon_filter(size_t fingerprint_bits, size_t seed);
+
+  /// Partitions the key digests and solves each partition.
+  void build(std::vector<uint64_t> const& digests, size_t threads);
+
+  /// Solves the system of a single partition.
+  void solve(partition const& p, std::vector<uint64_t> const& digests,
+             size_t first, size_t last, uint64_t seed);
+
+  size_t which(uint64_t digest) const;
+
+  size_t r_;
+  size_t seed_;
+  default_hash_function hash_;
+  size_t size_ = 0;
+  std::vector<partition> partitions_;
+  std::vector<uint64_t> solution_;
+};
+
+} // namespace bf
+
+#endif
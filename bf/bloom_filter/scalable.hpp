@@ -0,0 +1,84 @@
+#ifndef BF_BLOOM_FILTER_SCALABLE_HPP
+#define BF_BLOOM_FILTER_SCALABLE_HPP
+
+#include <bf/bloom_filter/basic.hpp>
+
+namespace bf {
+
+/// A scalable Bloom filter.
+///
+/// The filter grows without a capacity estimate by chaining basic Bloom
+/// filters, so-called slices. Once the newest slice reaches its capacity,
+/// the filter appends a slice with *s* times the capacity and a
+/// false-positive rate tightened by a factor *r*. With an initial rate of
+/// @f$P(1 - r)@f$, the compound false-positive rate remains below
+/// @f$P\sum_{i \ge 0} (1 - r) r^i = P@f$ regardless of the number of slices.
+class scalable_bloom_filter : public bloom_filter
+{
+public:
+  /// Constructs a scalable Bloom filter.
+  ///
+  /// @param fp The bound on the compound false-positive rate.
+  ///
+  /// @param capacity The capacity of the first slice.
+  ///
+  /// @param growth The factor *s* by which slice capacities grow.
+  ///
+  /// @param tightening The factor *r* by which slice false-positive rates
+  /// shrink.
+  ///
+  /// @param seed The initial seed used to construct the hash functions.
+  ///
+  /// @pre `0 < fp < 1 && capacity > 0 && growth > 0 && 0 < tightening < 1`
+  scalable_bloom_filter(double fp, size_t capacity = 1024, size_t growth = 2,
+                        double tightening = 0.85, size_t seed = 0);
+
+  scalable_bloom_filter(scalable_bloom_filter&&) = default;
+
+  using bloom_filter::add;
+  using bloom_filter::lookup;
+
+  /// Adds an element to the newest slice unless it already exists.
+  /// @param o The object to add.
+  virtual void add(object const& o) override;
+
+  /// Checks the slices for an element, newest first.
+  /// @param o The object to query.
+  /// @return 1 if *o* may exist and 0 otherwise.
+  virtual size_t lookup(object const& o) const override;
+
+  /// Checks a batch of elements against all slices. The implementation
+  /// computes the bit positions for a group of elements in all slices and
+  /// prefetches them before probing, so that cache misses overlap.
+  /// @param os The objects to query.
+  /// @return The results of ::lookup for each element.
+  virtual std::vector<size_t>
+  lookup(std::vector<object> const& os) const override;
+
+  /// Removes all elements and all slices but the first.
+  virtual void clear() override;
+
+  /// Retrieves the number of slices.
+  size_t slices() const;
+
+  /// Retrieves the number of elements added.
+  size_t size() const;
+
+private:
+  /// Appends a new slice.
+  void grow();
+
+  double fp_;
+  size_t capacity_;
+  size_t growth_;
+  double tightening_;
+  size_t seed_;
+  size_t size_ = 0;
+  size_t items_ = 0;              ///< Number of items in the newest slice.
+  std::vector<basic_bloom_filter> slices_;
+  std::vector<size_t> capacities_; ///< Maximum number of items per slice.
+};
+
+} // namespace bf
+
+#endif
@@ -1,12 +1,19 @@
 #ifndef BF_BLOOM_FILTER_STABLE_HPP
 #define BF_BLOOM_FILTER_STABLE_HPP
 
-#include <random>
+#include <cstdint>
 #include <bf/bloom_filter/counting.hpp>
 
 namespace bf {
 
 /// A stable Bloom filter.
+///
+/// Before each insertion, the filter decrements *d* cells to make room for
+/// new elements. Following the variant in Deng and Rafiei, "Approximately
+/// Detecting Duplicates for Streaming Data using Stable Bloom Filters", the
+/// cells form a contiguous run starting at a random offset, which has the
+/// same expected effect on each cell as *d* independent random cells but
+/// decrements whole blocks of cells at once.
 class stable_bloom_filter : public counting_bloom_filter
 {
 public:
@@ -15,12 +22,14 @@ public:
   /// @param cells The number of cells.
   /// @param width The number of bits per cell.
   /// @param d The number of cells to decrement before adding an element.
-  /// @pre `cells <= d`
-  stable_bloom_filter(hasher h, size_t cells, size_t width, size_t d);
+  /// @param seed The seed of the PRNG that selects the cells to decrement.
+  /// @pre `d <= cells`
+  stable_bloom_filter(hasher h, size_t cells, size_t width, size_t d,
+                      size_t seed = 0);
 
   /// Adds an item to the stable Bloom filter.
-  /// This invovles first decrementing *k* positions uniformly at random and
-  /// then setting the counter of *o* to all 1s.
+  /// This involves first decrementing *d* consecutive cells from a random
+  /// offset and then setting the counters of *o* to all 1s.
   /// @param o The object to add.
   virtual void add(object const& o) override;
 
@@ -29,8 +38,7 @@ public:
 
 private:
   size_t d_;
-  std::mt19937 generator_;
-  std::uniform_int_distribution<> unif_;
+  uint64_t state_; ///< The state of a SplitMix64 generator.
 };
 
 } // namespace bf
@@ -0,0 +1,105 @@
+#ifndef BF_BULK_HPP
+#define BF_BULK_HPP
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace bf {
+
+/// Runs a function on multiple threads, including the calling thread.
+/// @param threads The number of threads.
+/// @param work A function `void(size_t t)` invoked once for every *t* in
+/// `[0, threads)`.
+template <typename Work>
+void run_threads(size_t threads, Work work)
+{
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < threads; ++t)
+    workers.emplace_back(work, t);
+  work(0);
+  for (auto& w : workers)
+    w.join();
+}
+
+/// Applies the cells of many elements to a cell array using multiple
+/// threads, without atomic operations.
+///
+/// The keys are processed in batches. First, each thread hashes a slice of
+/// the batch and radix-partitions the resulting cells by *region*, a
+/// contiguous range of *region_cells* cells. Then each thread applies the
+/// cells of a disjoint range of regions, gathering them from all slices, so
+/// that every region is written by a single thread and stays in cache while
+/// it is updated.
+///
+/// @param n The number of keys.
+///
+/// @param cells The number of cells.
+///
+/// @param region_cells The number of cells per region. Regions must not
+/// share machine words, e.g., for bit vectors a multiple of 64.
+///
+/// @param threads The number of threads.
+///
+/// @param indices A function `void(size_t i, std::vector<size_t>& out)`
+/// that appends the cells of key *i* to *out*. It is called concurrently.
+///
+/// @param apply A function `void(size_t const* cells, size_t count)` that
+/// updates a span of cells within one region. It is called concurrently for
+/// different regions.
+///
+/// @pre `region_cells > 0 && threads > 0`
+template <typename Indices, typename Apply>
+void bulk_update(size_t n, size_t cells, size_t region_cells, size_t threads,
+                 Indices indices, Apply apply)
+{
+  assert(region_cells > 0 && threads > 0);
+  static size_t const keys_per_thread = 1 << 18;
+  auto regions = (cells + region_cells - 1) / region_cells;
+  if (regions == 0)
+    return;
+  // Per slice: the cells sorted by region, and the start of each region.
+  std::vector<std::vector<size_t>> sorted(threads);
+  std::vector<std::vector<size_t>> bounds(threads);
+  auto batch = threads * keys_per_thread;
+  for (size_t first = 0; first < n; first += batch) {
+    auto last = std::min(first + batch, n);
+    auto partition = [&](size_t t) {
+      auto per_thread = (last - first + threads - 1) / threads;
+      auto begin = std::min(first + t * per_thread, last);
+      auto end = std::min(begin + per_thread, last);
+      std::vector<size_t> raw;
+      for (auto i = begin; i < end; ++i)
+        indices(i, raw);
+      // Counting sort by region.
+      auto& b = bounds[t];
+      b.assign(regions + 1, 0);
+      for (auto c : raw)
+        ++b[c / region_cells + 1];
+      for (size_t r = 1; r <= regions; ++r)
+        b[r] += b[r - 1];
+      auto next = b;
+      auto& s = sorted[t];
+      s.resize(raw.size());
+      for (auto c : raw)
+        s[next[c / region_cells]++] = c;
+    };
+    auto update = [&](size_t t) {
+      auto begin = regions * t / threads;
+      auto end = regions * (t + 1) / threads;
+      for (auto r = begin; r < end; ++r)
+        for (size_t p = 0; p < threads; ++p)
+          if (bounds[p][r + 1] > bounds[p][r])
+            apply(sorted[p].data() + bounds[p][r],
+                  bounds[p][r + 1] - bounds[p][r]);
+    };
+    run_threads(threads, partition);
+    run_threads(threads, update);
+  }
+}
+
+} // namespace bf
+
+#endif
@@ -33,12 +33,50 @@ public:
   /// @pre `cells > 0 && width > 0`
   counter_vector(size_t cells, size_t width);
 
+  /// Constructs a counter vector from the bits of its cells, e.g., after
+  /// deserializing them.
+  ///
+  /// @param bits The concatenated cells.
+  ///
+  /// @param width The number of bits per cell.
+  ///
+  /// @pre `width > 0 && bits.size() > 0 && bits.size() % width == 0`
+  counter_vector(bitvector bits, size_t width);
+
   /// Merges this counter vector with another counter vector.
   /// @param other The other counter vector.
   /// @return A reference to `*this`.
   /// @pre `size() == other.size() && width() == other.width()`
   counter_vector& operator|=(counter_vector const& other);
 
+  /// Adds the counters of another counter vector in a range of cells,
+  /// saturating at max(). If the cell width divides the block size, the
+  /// implementation processes a whole block of cells at once.
+  ///
+  /// @param other The other counter vector.
+  ///
+  /// @param first The first cell.
+  ///
+  /// @param last One past the last cell.
+  ///
+  /// @pre `size() == other.size() && width() == other.width()`
+  /// @pre `first <= last && last <= size()`
+  void add_range(counter_vector const& other, size_t first, size_t last);
+
+  /// Replaces the counters in a range of cells by their minimum with the
+  /// counters of another counter vector, processing whole blocks at once
+  /// under the same condition as ::add_range.
+  ///
+  /// @param other The other counter vector.
+  ///
+  /// @param first The first cell.
+  ///
+  /// @param last One past the last cell.
+  ///
+  /// @pre `size() == other.size() && width() == other.width()`
+  /// @pre `first <= last && last <= size()`
+  void min_range(counter_vector const& other, size_t first, size_t last);
+
   /// Increments a cell counter by a given value. If the value is larger 
   /// than or equal to max(), all bits are set to 1.
   ///
@@ -52,16 +90,44 @@ public:
   /// @pre `cell < size()`
   bool increment(size_t cell, size_t value = 1);
 
-  /// Decrements a cell counter.
+  /// Decrements a cell counter. If the value is larger than the counter,
+  /// the counter becomes 0.
   ///
   /// @param cell The cell index.
   ///
-  /// @return `true` if decrementing succeeded, `false` if all bits in the
-  /// cell were already 0.
+  /// @param value The value that is subtracted from the current cell value.
+  ///
+  /// @return `true` if decrementing succeeded, `false` if the cell value was
+  /// smaller than *value*.
   ///
   /// @pre `cell < size()`
   bool decrement(size_t cell, size_t value = 1);
 
+  /// Decrements all nonzero counters in a range of cells by 1. If the cell
+  /// width divides the block size, the implementation processes a whole
+  /// block of cells at once.
+  ///
+  /// @param first The first cell.
+  ///
+  /// @param last One past the last cell.
+  ///
+  /// @pre `first <= last && last <= size()`
+  void decrement_range(size_t first, size_t last);
+
+  /// Counts the cells in a range that hold a given value, processing whole
+  /// blocks at once under the same condition as ::decrement_range.
+  ///
+  /// @param first The first cell.
+  ///
+  /// @param last One past the last cell.
+  ///
+  /// @param value The value to count.
+  ///
+  /// @return The number of cells in `[first, last)` equal to *value*.
+  ///
+  /// @pre `first <= last && last <= size() && value <= max()`
+  size_t count_equal(size_t first, size_t last, size_t value) const;
+
   /// Retrieves the counter of a cell.
   ///
   /// @param cell The cell index.
@@ -77,6 +143,11 @@ public:
   /// @pre `cell < size()`
   void set(size_t cell, size_t value);
 
+  /// Hints the processor to load a cell into the cache.
+  /// @param cell The cell index.
+  /// @pre `cell < size()`
+  void prefetch(size_t cell) const;
+
   /// Sets all counter values to 0.
   void clear();
 
@@ -92,6 +163,10 @@ public:
   /// @return The number of bits per cell.
   size_t width() const;
 
+  /// Retrieves the concatenated cells.
+  /// @return The underlying bit vector.
+  bitvector const& bits() const;
+
 private:
   bitvector bits_;
   size_t width_;
@@ -0,0 +1,120 @@
+#ifndef BF_EVALUATION_HPP
+#define BF_EVALUATION_HPP
+
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <string>
+#include <vector>
+#include <bf/bloom_filter.hpp>
+
+namespace bf {
+
+/// Describes a synthetic key set and the queries against it.
+struct workload
+{
+  /// The distribution of keys and queries.
+  enum distribution_type
+  {
+    uniform,    ///< Random 64-bit integers.
+    zipf,       ///< A random subset of a universe, queried Zipf-distributed.
+    sequential, ///< Consecutive 64-bit integers, queried past the last key.
+    strings,    ///< Random alphanumeric strings of varying length.
+  };
+
+  distribution_type distribution = uniform;
+  size_t keys = 100000;
+  size_t queries = 100000;
+  double skew = 1.0;      ///< The Zipf exponent.
+  size_t min_length = 8;  ///< The minimum string length.
+  size_t max_length = 32; ///< The maximum string length.
+  uint64_t seed = 0;
+};
+
+/// Parses the name of a key distribution.
+/// @param name One of `uniform`, `zipf`, `sequential`, or `strings`.
+/// @return The distribution named *name*.
+/// @throws std::invalid_argument if *name* is unknown.
+workload::distribution_type parse_distribution(std::string const& name);
+
+/// The keys and queries of a workload with their ground truth.
+class dataset
+{
+public:
+  /// Generates a data set.
+  /// @param w The workload to generate.
+  /// @pre `w.min_length > 0 && w.min_length <= w.max_length`
+  explicit dataset(workload const& w);
+
+  /// Retrieves the distinct keys.
+  std::vector<object> const& keys() const;
+
+  /// Retrieves the queries.
+  std::vector<object> const& queries() const;
+
+  /// Checks whether a query is a key.
+  /// @param i The index of the query.
+  /// @return `true` iff query *i* is among the keys.
+  bool member(size_t i) const;
+
+private:
+  std::vector<char> bytes_;
+  std::vector<object> keys_;
+  std::vector<object> queries_;
+  std::vector<bool> members_;
+};
+
+/// A filter configuration under evaluation.
+struct candidate
+{
+  std::string name;
+
+  /// Constructs the filter and adds all keys to it.
+  std::function<std::unique_ptr<bloom_filter>(std::vector<object> const&)>
+    build;
+
+  /// Computes the number of bits a built filter occupies.
+  std::function<size_t(bloom_filter const&)> bits;
+};
+
+/// The measurements of a candidate on a data set.
+struct evaluation
+{
+  std::string name;
+  size_t keys = 0;
+  size_t queries = 0;
+  size_t negatives = 0; ///< The number of queries that are not keys.
+  size_t false_positives = 0;
+  size_t false_negatives = 0;
+  double bits_per_key = 0;
+  double build_rate = 0; ///< Keys per second.
+  double query_rate = 0; ///< Queries per second.
+
+  /// Retrieves the empirical false-positive rate.
+  double fp_rate() const
+  {
+    return negatives == 0 ? 0
+                          : static_cast<double>(false_positives) / negatives;
+  }
+};
+
+/// Builds a candidate from the keys of a data set and queries it.
+/// @param c The candidate.
+/// @param data The data set.
+/// @return The measurements.
+evaluation evaluate(candidate const& c, dataset const& data);
+
+/// Writes evaluations as a CSV table with a header row.
+/// @param out The stream to write to.
+/// @param results The evaluations.
+void write_csv(std::ostream& out, std::vector<evaluation> const& results);
+
+/// Writes evaluations as a JSON array of objects.
+/// @param out The stream to write to.
+/// @param results The evaluations.
+void write_json(std::ostream& out, std::vector<evaluation> const& results);
+
+} // namespace bf
+
+#endif
@@ -0,0 +1,90 @@
+#ifndef BF_FUSE_GRAPH_HPP
+#define BF_FUSE_GRAPH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace bf {
+
+/// The segmented 3-hypergraph underlying binary fuse filters.
+///
+/// The graph has an array of slots divided into segments. Each hash value
+/// maps to three slots in consecutive segments. Peeling the graph yields an
+/// order in which each key has a slot that no later key uses, which allows
+/// assigning slot values such that the values at the three slots of every
+/// key XOR to an arbitrary per-key value.
+///
+/// Reference: Graf and Lemire, "Binary Fuse Filters: Fast and Smaller Than
+/// Xor Filters", 2022.
+class fuse_graph
+{
+public:
+  /// A key in peeling order: the position of its hash in the input and the
+  /// index (0, 1, or 2) of its free slot.
+  typedef std::pair<size_t, uint8_t> peeled;
+
+  /// Constructs an empty graph.
+  fuse_graph() = default;
+
+  /// Constructs a graph for a given number of keys.
+  /// @param n The number of keys.
+  explicit fuse_graph(size_t n);
+
+  /// Constructs a graph from a previously computed layout.
+  ///
+  /// @param segment_length The number of slots per segment.
+  ///
+  /// @param segment_count_length The number of slots that the first of the
+  /// three slots of a key may fall into.
+  ///
+  /// @param slots The total number of slots.
+  ///
+  /// @throws std::runtime_error if the layout is invalid.
+  fuse_graph(uint64_t segment_length, uint64_t segment_count_length,
+             uint64_t slots);
+
+  /// Computes the three slots of a hash value.
+  /// @param h The hash value.
+  /// @param slots Receives the slots.
+  void locate(uint64_t h, size_t (&slots)[3]) const
+  {
+    auto mask = segment_length_ - 1;
+    slots[0] = (static_cast<unsigned __int128>(h) * segment_count_length_)
+               >> 64;
+    slots[1] = slots[0] + segment_length_;
+    slots[2] = slots[1] + segment_length_;
+    slots[1] ^= (h >> 18) & mask;
+    slots[2] ^= h & mask;
+  }
+
+  /// Peels the graph of a set of hash values.
+  ///
+  /// @param hashes The distinct hash values of the keys.
+  ///
+  /// @param order Receives the keys in the reverse of the order in which
+  /// their free slots must be assigned.
+  ///
+  /// @return `true` iff peeling succeeded for all keys.
+  bool peel(std::vector<uint64_t> const& hashes,
+            std::vector<peeled>& order) const;
+
+  /// Retrieves the number of slots per segment.
+  uint64_t segment_length() const;
+
+  /// Retrieves the number of slots the first slot of a key may fall into.
+  uint64_t segment_count_length() const;
+
+  /// Retrieves the total number of slots.
+  uint64_t slots() const;
+
+private:
+  uint64_t segment_length_ = 0;
+  uint64_t segment_count_length_ = 0;
+  uint64_t slots_ = 0;
+};
+
+} // namespace bf
+
+#endif
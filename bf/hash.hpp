@@ -1,6 +1,7 @@
 #ifndef BF_HASH_POLICY_HPP
 #define BF_HASH_POLICY_HPP
 
+#include <cstdint>
 #include <functional>
 #include <bf/h3.hpp>
 #include <bf/object.hpp>
@@ -16,6 +17,31 @@ typedef std::function<digest(object const&)> hash_function;
 /// A function that hashes an object *k* times.
 typedef std::function<std::vector<digest>(object const&)> hasher;
 
+/// Applies the finalizer of MurmurHash3, a bijection that scatters the bits
+/// of a 64-bit integer.
+/// @param h The integer to mix.
+/// @return The mixed integer.
+inline uint64_t murmur64(uint64_t h)
+{
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+/// Advances a SplitMix64 generator.
+/// @param state The state of the generator.
+/// @return The next pseudo-random number.
+inline uint64_t splitmix64(uint64_t& state)
+{
+  auto z = (state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
 class default_hash_function
 {
 public:
@@ -29,16 +55,45 @@ private:
   h3<size_t, max_obj_size> h3_;
 };
 
+/// Describes how ::make_hasher constructed a hasher, so that an identical
+/// hasher can be rebuilt, e.g., after deserializing a filter.
+struct hasher_descriptor
+{
+  /// The family of the underlying hash functions.
+  enum family_type : uint32_t
+  {
+    custom = 0, ///< User-supplied hash functions that cannot be rebuilt.
+    h3 = 1,     ///< The ::default_hash_function.
+  };
+
+  /// How a filter maps digests to cells.
+  enum mapping_type : uint32_t
+  {
+    modulo = 0,      ///< Each digest modulo the number of cells.
+    partitioned = 1, ///< Each digest into its own partition of the cells.
+  };
+
+  family_type family = custom;
+  size_t k = 0;
+  size_t seed = 0; ///< The seed of the PRNG that generates the seeds.
+  bool double_hashing = false;
+  mapping_type mapping = modulo;
+};
+
 /// A hasher which hashes an object *k* times.
 class default_hasher
 {
 public:
-  default_hasher(std::vector<hash_function> fns);
+  default_hasher(std::vector<hash_function> fns, hasher_descriptor d = {});
 
   std::vector<digest> operator()(object const& o) const;
 
+  /// Retrieves the descriptor the hasher was constructed with.
+  hasher_descriptor const& descriptor() const;
+
 private:
   std::vector<hash_function> fns_;
+  hasher_descriptor descriptor_;
 };
 
 /// A hasher which hashes an object two times and generates *k* digests through
@@ -46,14 +101,19 @@ private:
 class double_hasher
 {
 public:
-  double_hasher(size_t k, hash_function h1, hash_function h2);
+  double_hasher(size_t k, hash_function h1, hash_function h2,
+                hasher_descriptor d = {});
 
   std::vector<digest> operator()(object const& o) const;
 
+  /// Retrieves the descriptor the hasher was constructed with.
+  hasher_descriptor const& descriptor() const;
+
 private:
   size_t k_;
   hash_function h1_;
   hash_function h2_;
+  hasher_descriptor descriptor_;
 };
 
 /// Creates a default or double hasher with the default hash function, using
@@ -71,6 +131,36 @@ private:
 /// @pre `k > 0`
 hasher make_hasher(size_t k, size_t seed = 0, bool double_hashing = false);
 
+/// Rebuilds a hasher from its descriptor. The hasher carries the descriptor,
+/// except for the index mapping, which belongs to the filter.
+///
+/// @param d The descriptor of the hasher.
+///
+/// @return A ::hasher that produces the same digests as the hasher *d*
+/// describes.
+///
+/// @throws std::invalid_argument if *d* describes a custom hasher or `d.k`
+/// is 0.
+hasher make_hasher(hasher_descriptor const& d);
+
+/// Retrieves the descriptor of a hasher.
+///
+/// @param h The hasher.
+///
+/// @return The descriptor of *h* if ::make_hasher constructed it, and a
+/// descriptor of a custom hasher otherwise.
+hasher_descriptor describe(hasher const& h);
+
+/// Computes a fingerprint of a hasher from the digests of a fixed probe
+/// object. Hashers with the same hash functions, e.g., the same number of
+/// functions, seeds, and hashing mode, have the same fingerprint; different
+/// hashers have different fingerprints with high probability.
+///
+/// @param h The hasher.
+///
+/// @return The fingerprint of *h*.
+uint64_t fingerprint(hasher const& h);
+
 } // namespace bf
 
 #endif
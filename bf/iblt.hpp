@@ -0,0 +1,122 @@
+#ifndef BF_IBLT_HPP
+#define BF_IBLT_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <vector>
+#include <bf/hash.hpp>
+
+namespace bf {
+
+/// An invertible Bloom lookup table (IBLT) over 64-bit keys.
+///
+/// Each key maps to *k* cells, one per partition of the table. A cell holds
+/// the number of keys mapped to it, the XOR of these keys, and the XOR of
+/// their checksums. A cell with a count of &plusmn;1 whose checksum matches
+/// its key is *pure* and reveals a key, whose removal may in turn make other
+/// cells pure. This peeling process lists all entries as long as the table
+/// holds not many more than @f$m / 1.5@f$ keys, for *m* cells and *k = 3*.
+///
+/// To reconcile two sets, each replica builds a table with the same
+/// parameters; subtracting one table from the other cancels all common keys,
+/// so that listing the entries of the difference recovers the symmetric
+/// difference. The table size thus depends only on the size of the
+/// difference, not on the size of the sets.
+///
+/// Reference: Eppstein, Goodrich, Uyeda, and Varghese, "What's the
+/// Difference? Efficient Set Reconciliation without Prior Context", 2011.
+class iblt
+{
+public:
+  /// Computes the number of cells to recover a given number of entries with
+  /// high probability.
+  /// @param entries The expected size of the symmetric difference.
+  /// @param k The number of cells per key.
+  /// @return The number of cells, a multiple of *k*.
+  static size_t cells(size_t entries, size_t k = 3);
+
+  /// Constructs an IBLT.
+  ///
+  /// @param cells The number of cells.
+  ///
+  /// @param k The number of cells per key.
+  ///
+  /// @param seed The initial seed used to construct the hash functions.
+  ///
+  /// @pre `k > 0 && cells >= k`
+  iblt(size_t cells, size_t k = 3, size_t seed = 0);
+
+  /// Inserts a key.
+  /// @param key The key to insert.
+  void insert(uint64_t key);
+
+  /// Erases a key. Erasing a key not in the table records a negative entry.
+  /// @param key The key to erase.
+  void erase(uint64_t key);
+
+  /// Subtracts another table cell by cell.
+  /// @param other The table to subtract.
+  /// @throws std::invalid_argument if the tables have different parameters.
+  void subtract(iblt const& other);
+
+  /// Lists the entries by peeling a copy of the table.
+  ///
+  /// @param inserted Receives the keys with a positive count, i.e., the keys
+  /// only in this table after a subtraction.
+  ///
+  /// @param erased Receives the keys with a negative count, i.e., the keys
+  /// only in the subtracted table.
+  ///
+  /// @return `true` if the peeling recovered all entries, and `false` if
+  /// the table holds too many entries, in which case the output is partial.
+  bool list_entries(std::vector<uint64_t>& inserted,
+                    std::vector<uint64_t>& erased) const;
+
+  /// Removes all entries.
+  void clear();
+
+  /// Serializes the table.
+  /// @param out The stream to write to.
+  void save(std::ostream& out) const;
+
+  /// Loads a table from a stream.
+  /// @param in The stream to read from.
+  /// @return The deserialized table.
+  /// @throws std::runtime_error if *in* does not contain a valid table.
+  static iblt load(std::istream& in);
+
+  /// Retrieves the number of cells.
+  size_t size() const;
+
+  /// Retrieves the number of cells per key.
+  size_t k() const;
+
+private:
+  struct cell
+  {
+    int64_t count;
+    uint64_t key_sum;
+    uint64_t hash_sum;
+  };
+
+  /// Adds a key with a given multiplicity to its cells.
+  void update(uint64_t key, int64_t delta);
+
+  /// Computes the cells of a key, one per partition.
+  std::vector<size_t> find_indices(uint64_t key) const;
+
+  /// Computes the checksum of a key.
+  uint64_t checksum(uint64_t key) const;
+
+  /// Checks whether a cell holds exactly one key.
+  bool pure(cell const& c) const;
+
+  size_t k_;
+  size_t seed_;
+  hasher hasher_;
+  std::vector<cell> cells_;
+};
+
+} // namespace bf
+
+#endif
@@ -0,0 +1,91 @@
+#ifndef BF_MERGE_HPP
+#define BF_MERGE_HPP
+
+#include <string>
+#include <vector>
+#include <bf/bloom_filter/basic.hpp>
+#include <bf/bloom_filter/counting.hpp>
+
+namespace bf {
+
+/// Computes the union of many basic Bloom filters using multiple threads.
+/// Each thread ORs a disjoint range of blocks of all inputs into the result,
+/// one cache-sized chunk at a time, so that every input is read once.
+///
+/// @param filters The filters to merge.
+///
+/// @param threads The number of threads.
+///
+/// @return A filter with the hasher of the first filter whose bit vector is
+/// the union of all bit vectors.
+///
+/// @throws std::invalid_argument if *filters* is empty or the filters differ
+/// in size, hasher (number of hash functions, seeds, and hashing mode), or
+/// partitioning.
+///
+/// @pre `threads > 0`
+basic_bloom_filter merge(std::vector<basic_bloom_filter const*> const& filters,
+                         size_t threads = 1);
+
+/// Computes the union of many counting Bloom filters using multiple threads
+/// by adding their counters, saturating at the maximum counter value.
+///
+/// @param filters The filters to merge.
+///
+/// @param threads The number of threads.
+///
+/// @return A filter with the hasher of the first filter whose counters are
+/// the sums of all counters.
+///
+/// @throws std::invalid_argument if *filters* is empty or the filters differ
+/// in size, counter width, hasher, or partitioning.
+///
+/// @pre `threads > 0`
+counting_bloom_filter
+merge(std::vector<counting_bloom_filter const*> const& filters,
+      size_t threads = 1);
+
+/// Computes the union of basic Bloom filters serialized with
+/// basic_bloom_filter::save. The files are mapped into memory and streamed
+/// through in chunks rather than loaded.
+///
+/// @param filenames The files to merge.
+///
+/// @param h The hasher the filters were constructed with.
+///
+/// @param threads The number of threads.
+///
+/// @return The union of the filters in *filenames*.
+///
+/// @throws std::runtime_error if a file does not contain a valid filter.
+///
+/// @throws std::invalid_argument if *filenames* is empty or the filters
+/// differ in size or partitioning, or *h* does not match them.
+///
+/// @pre `threads > 0`
+basic_bloom_filter merge_files(std::vector<std::string> const& filenames,
+                               hasher h, size_t threads = 1);
+
+/// Computes the union of basic Bloom filters serialized with
+/// basic_bloom_filter::save, rebuilding the hasher from the descriptor in
+/// the first file.
+///
+/// @param filenames The files to merge.
+///
+/// @param threads The number of threads.
+///
+/// @return The union of the filters in *filenames*.
+///
+/// @throws std::runtime_error if a file does not contain a valid filter.
+///
+/// @throws std::invalid_argument if *filenames* is empty, the first filter
+/// has a custom hasher, or the filters differ in size, partitioning, or
+/// hasher.
+///
+/// @pre `threads > 0`
+basic_bloom_filter merge_files(std::vector<std::string> const& filenames,
+                               size_t threads = 1);
+
+} // namespace bf
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef BF_METRICS_HPP
+#define BF_METRICS_HPP
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace bf {
+
+/// The events that instrumented Bloom filters record.
+enum class event : size_t
+{
+  add,
+  lookup,
+  remove,
+  overflow,  ///< A counter saturated during an increment.
+  underflow, ///< A counter was too small for a decrement.
+};
+
+/// Event counters that are cheap to update concurrently.
+///
+/// Each thread that records an event receives its own slot of counters on
+/// first use. Only the owning thread writes a slot, so recording is a plain
+/// load and store without a locked instruction, and slots occupy separate
+/// cache lines, so that concurrent readers of a filter do not contend. A
+/// small thread-local cache maps counters to the slot of the calling thread.
+/// Reading a total sums over all slots.
+class event_counters
+{
+public:
+  /// The number of distinct events.
+  static constexpr size_t events = 5;
+
+  event_counters();
+  ~event_counters();
+  event_counters(event_counters&&);
+  event_counters& operator=(event_counters&&);
+
+  /// Records occurrences of an event.
+  /// @param e The event.
+  /// @param n The number of occurrences.
+  void record(event e, size_t n = 1) const
+  {
+    auto& c = local().counts[static_cast<size_t>(e)];
+    c.store(c.load(std::memory_order_relaxed) + n,
+            std::memory_order_relaxed);
+  }
+
+  /// Retrieves the number of occurrences of an event.
+  /// @param e The event.
+  /// @return The sum over all slots since the last reset.
+  size_t total(event e) const;
+
+  /// Sets all counters to 0.
+  void reset();
+
+private:
+  struct slot
+  {
+    std::atomic<size_t> counts[events];
+  };
+
+  struct state;
+
+  /// Retrieves the slot of the calling thread, taking it from the
+  /// thread-local cache if possible.
+  slot& local() const
+  {
+    auto& entry = cache[id_ % cache_size];
+    return entry.id == id_ ? *entry.target : attach();
+  }
+
+  /// Finds or creates the slot of the calling thread and caches it.
+  slot& attach() const;
+
+  static constexpr size_t cache_size = 8;
+
+  struct cache_entry
+  {
+    uint64_t id;
+    slot* target;
+  };
+
+  static thread_local cache_entry cache[cache_size];
+
+  uint64_t id_; ///< Unique across all counters, so never reused.
+  std::unique_ptr<state> state_;
+};
+
+/// A snapshot of the health of a Bloom filter.
+struct filter_metrics
+{
+  size_t cells = 0;          ///< The number of bits or counters.
+  size_t hash_functions = 0; ///< The number of cells per element.
+  size_t nonzero = 0;        ///< The number of set bits or nonzero counters.
+  size_t saturated = 0;      ///< The number of counters at their maximum.
+  size_t adds = 0;
+  size_t lookups = 0;
+  size_t removes = 0;
+  size_t overflows = 0;
+  size_t underflows = 0;
+
+  /// Retrieves the fraction of nonzero cells.
+  double fill_ratio() const
+  {
+    return cells == 0 ? 0 : static_cast<double>(nonzero) / cells;
+  }
+
+  /// Estimates the current false-positive rate as the probability that all
+  /// cells of an element not in the filter are nonzero.
+  double fp_rate() const
+  {
+    return std::pow(fill_ratio(), static_cast<double>(hash_functions));
+  }
+};
+
+} // namespace bf
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef BF_SERIALIZATION_HPP
+#define BF_SERIALIZATION_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <iosfwd>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include <bf/hash.hpp>
+
+namespace bf {
+
+/// Identifies the type of a serialized data structure.
+enum class serialization_tag : uint32_t
+{
+  binary_fuse_filter = 1,
+  iblt = 2,
+  static_function = 3,
+  basic_bloom_filter = 4,
+  counting_bloom_filter = 5,
+};
+
+/// Writes the binary representation of an arithmetic value in host byte
+/// order.
+/// @param out The stream to write to.
+/// @param x The value to write.
+template <
+  typename T,
+  typename = typename std::enable_if<std::is_arithmetic<T>::value>::type
+>
+void write(std::ostream& out, T x)
+{
+  out.write(reinterpret_cast<char const*>(&x), sizeof(T));
+}
+
+/// Writes the header that precedes every serialized data structure.
+/// @param out The stream to write to.
+/// @param tag The type of the data structure that follows.
+void write_header(std::ostream& out, serialization_tag tag);
+
+/// A cursor over a contiguous region of serialized bytes. The region may
+/// live in memory that the reader does not own, e.g., a memory-mapped file.
+class reader
+{
+public:
+  /// Constructs a reader.
+  /// @param data The beginning of the region.
+  /// @param size The number of bytes in the region.
+  reader(void const* data, size_t size);
+
+  /// Reads an arithmetic value in host byte order.
+  /// @throws std::runtime_error if the region is exhausted.
+  template <
+    typename T,
+    typename = typename std::enable_if<std::is_arithmetic<T>::value>::type
+  >
+  T read()
+  {
+    T x;
+    std::memcpy(&x, skip(sizeof(T)), sizeof(T));
+    return x;
+  }
+
+  /// Reads and verifies a header.
+  /// @param tag The expected type of the data structure.
+  /// @throws std::runtime_error if the header does not match *tag*.
+  void read_header(serialization_tag tag);
+
+  /// Advances the cursor.
+  /// @param n The number of bytes to skip.
+  /// @return A pointer to the skipped bytes.
+  /// @throws std::runtime_error if fewer than *n* bytes remain.
+  void const* skip(size_t n);
+
+  /// Retrieves the number of bytes left.
+  size_t remaining() const;
+
+private:
+  char const* data_;
+  size_t size_;
+};
+
+/// A read-only memory mapping of a file.
+class mapped_file
+{
+  mapped_file(mapped_file const&) = delete;
+  mapped_file& operator=(mapped_file const&) = delete;
+
+public:
+  /// Maps a file into memory.
+  /// @param filename The file to map.
+  /// @throws std::runtime_error if the file cannot be opened or mapped.
+  explicit mapped_file(std::string const& filename);
+
+  ~mapped_file();
+
+  /// Retrieves the beginning of the mapped region.
+  void const* data() const;
+
+  /// Retrieves the size of the mapped region in bytes.
+  size_t size() const;
+
+private:
+  void* data_ = nullptr;
+  size_t size_ = 0;
+};
+
+/// Writes a hasher descriptor.
+/// @param out The stream to write to.
+/// @param d The descriptor to write.
+void write_descriptor(std::ostream& out, hasher_descriptor const& d);
+
+/// Reads a hasher descriptor written by ::write_descriptor.
+/// @param source The reader to read from.
+/// @return The descriptor.
+/// @throws std::runtime_error if the descriptor is invalid.
+hasher_descriptor read_descriptor(reader& source);
+
+/// Computes the size of the cells of a serialized filter and checks that the
+/// input holds them, so that a corrupt header cannot trigger a huge
+/// allocation.
+/// @param source The reader positioned at the cells.
+/// @param cells The number of cells.
+/// @param width The number of bits per cell.
+/// @return The number of bytes of the cells, padded to whole blocks of a
+/// bitvector.
+/// @throws std::runtime_error if *cells* or *width* is 0, *width* exceeds
+/// 64, or fewer bytes remain.
+size_t cell_bytes(reader const& source, uint64_t cells, uint64_t width = 1);
+
+/// Reads the remainder of a stream into memory.
+/// @param in The stream to read from.
+/// @return A buffer holding all bytes of *in*.
+std::shared_ptr<std::vector<char>> slurp(std::istream& in);
+
+} // namespace bf
+
+#endif
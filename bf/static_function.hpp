@@ -0,0 +1,104 @@
+#ifndef BF_STATIC_FUNCTION_HPP
+#define BF_STATIC_FUNCTION_HPP
+
+#include <cstdint>
+#include <iosfwd>
+#include <utility>
+#include <vector>
+#include <bf/fuse_graph.hpp>
+#include <bf/hash.hpp>
+
+namespace bf {
+
+/// A static function (Bloomier filter) that maps keys to small values.
+///
+/// The function stores one value per slot of a binary fuse graph, such that
+/// the values at the three slots of a key XOR to the value of the key. The
+/// slots are bit-packed, so the function uses @f$\approx 1.125 r@f$ bits per
+/// key for *r*-bit values, independent of the key size, and lookups require
+/// three memory accesses.
+///
+/// Looking up a key outside the construction set yields an arbitrary value.
+/// To also detect such keys, store a fingerprint alongside the value, e.g.,
+/// in the upper bits.
+///
+/// Reference: Chazelle, Kilian, Rubinfeld, and Tal, "The Bloomier Filter: An
+/// Efficient Data Structure for Static Support Lookup Tables", 2004.
+class static_function
+{
+public:
+  /// Constructs a static function from a range of key-value pairs.
+  ///
+  /// @param first An iterator to the first pair.
+  ///
+  /// @param last An iterator one past the last pair.
+  ///
+  /// @param value_bits The number of bits per value, at most 16.
+  ///
+  /// @param seed The initial seed used to construct the hash function.
+  ///
+  /// @throws std::invalid_argument if a value does not fit in *value_bits*
+  /// bits or a key occurs with different values.
+  ///
+  /// @throws std::runtime_error if construction fails, which happens with
+  /// negligible probability.
+  template <typename Iterator>
+  static_function(Iterator first, Iterator last, size_t value_bits = 8,
+                  size_t seed = 0)
+    : static_function(value_bits, seed)
+  {
+    std::vector<std::pair<uint64_t, uint64_t>> entries;
+    for (; first != last; ++first)
+      entries.emplace_back(hash_(wrap(first->first)), first->second);
+    build(std::move(entries));
+  }
+
+  /// Loads a function from a stream.
+  /// @param in The stream to read from.
+  /// @return The deserialized function.
+  /// @throws std::runtime_error if *in* does not contain a valid function.
+  static static_function load(std::istream& in);
+
+  /// Retrieves the value of a key.
+  /// @param o The key.
+  /// @return The value of *o* if *o* was in the construction set, and an
+  /// arbitrary value otherwise.
+  uint64_t lookup(object const& o) const;
+
+  template <typename T>
+  uint64_t lookup(T const& x) const
+  {
+    return lookup(wrap(x));
+  }
+
+  /// Serializes the function.
+  /// @param out The stream to write to.
+  void save(std::ostream& out) const;
+
+  /// Retrieves the number of keys the function was constructed from.
+  size_t size() const;
+
+  /// Retrieves the number of value slots.
+  size_t slots() const;
+
+  /// Retrieves the number of bits per value.
+  size_t value_bits() const;
+
+private:
+  static_function(size_t value_bits, size_t seed);
+
+  /// Solves the XOR system for a set of digest-value pairs.
+  void build(std::vector<std::pair<uint64_t, uint64_t>> entries);
+
+  size_t seed_;
+  default_hash_function hash_;
+  size_t bits_;
+  size_t size_ = 0;
+  uint64_t mix_ = 0;
+  fuse_graph graph_;
+  std::vector<unsigned char> values_; ///< Bit-packed, plus padding.
+};
+
+} // namespace bf
+
+#endif
@@ -41,6 +41,11 @@ inline object wrap(std::string const& str)
   return {str.data(), str.size()};
 }
 
+inline object wrap(object const& o)
+{
+  return o;
+}
+
 } // namespace bf
 
 #endif
@@ -10,17 +10,21 @@ typedef bitvector::block_type block_type;
 
 namespace {
 
-uint8_t count_table[] = {
-  0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3,
-  3, 4, 3, 4, 4, 5, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 2, 3, 3, 4,
-  3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 1, 2, 2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4,
-  4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 2, 3, 3, 4, 3, 4, 4, 5,
-  3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7, 1, 2,
-  2, 3, 2, 3, 3, 4, 2, 3, 3, 4, 3, 4, 4, 5, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5,
-  4, 5, 5, 6, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6, 3, 4, 4, 5, 4, 5,
-  5, 6, 4, 5, 5, 6, 5, 6, 6, 7, 2, 3, 3, 4, 3, 4, 4, 5, 3, 4, 4, 5, 4, 5, 5, 6,
-  3, 4, 4, 5, 4, 5, 5, 6, 4, 5, 5, 6, 5, 6, 6, 7, 3, 4, 4, 5, 4, 5, 5, 6, 4, 5,
-  5, 6, 5, 6, 6, 7, 4, 5, 5, 6, 5, 6, 6, 7, 5, 6, 6, 7, 6, 7, 7, 8};
+// Computes the population count of a range of blocks. Four independent
+// accumulators keep the popcount units busy.
+size_type popcount(block_type const* first, size_type n) {
+  size_type c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+  size_type i = 0;
+  for (; i + 4 <= n; i += 4) {
+    c0 += __builtin_popcountll(first[i]);
+    c1 += __builtin_popcountll(first[i + 1]);
+    c2 += __builtin_popcountll(first[i + 2]);
+    c3 += __builtin_popcountll(first[i + 3]);
+  }
+  for (; i < n; ++i)
+    c0 += __builtin_popcountll(first[i]);
+  return c0 + c1 + c2 + c3;
+}
 
 } // namespace <anonymous>
 
@@ -203,6 +207,19 @@ bitvector& bitvector::operator-=(bitvector const& other) {
   return *this;
 }
 
+void count_joint(bitvector const& x, bitvector const& y, size_type& cx,
+                 size_type& cy, size_type& cxy) {
+  assert(x.size() == y.size());
+  auto xs = x.bits_.data();
+  auto ys = y.bits_.data();
+  cx = cy = cxy = 0;
+  for (size_type i = 0; i < x.bits_.size(); ++i) {
+    cx += __builtin_popcountll(xs[i]);
+    cy += __builtin_popcountll(ys[i]);
+    cxy += __builtin_popcountll(xs[i] & ys[i]);
+  }
+}
+
 bitvector operator&(bitvector const& x, bitvector const& y) {
   bitvector b(x);
   return b &= y;
@@ -332,27 +349,27 @@ bitvector::reference bitvector::operator[](size_type i) {
   return {bits_[block_index(i)], bit_index(i)};
 }
 
+void bitvector::prefetch(size_type i) const {
+  assert(i < num_bits_);
+  __builtin_prefetch(&bits_[block_index(i)]);
+}
+
 size_type bitvector::count() const {
-  auto first = bits_.begin();
-  size_t n = 0;
-  auto length = blocks();
-  while (length) {
-    auto block = *first;
-    while (block) {
-      // TODO: use __popcnt if available.
-      n += count_table[block & ((1u << 8) - 1)];
-      block >>= 8;
-    }
-    ++first;
-    --length;
-  }
-  return n;
+  return popcount(bits_.data(), bits_.size());
 }
 
 size_type bitvector::blocks() const {
   return bits_.size();
 }
 
+block_type* bitvector::data() {
+  return bits_.data();
+}
+
+block_type const* bitvector::data() const {
+  return bits_.data();
+}
+
 size_type bitvector::size() const {
   return num_bits_;
 }
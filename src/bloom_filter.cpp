@@ -0,0 +1,17 @@
+#include <bf/bloom_filter.hpp>
+
+namespace bf {
+
+void bloom_filter::add(std::vector<object> const& os) {
+  for (auto& o : os)
+    add(o);
+}
+
+std::vector<size_t> bloom_filter::lookup(std::vector<object> const& os) const {
+  std::vector<size_t> result(os.size());
+  for (size_t i = 0; i < os.size(); ++i)
+    result[i] = lookup(os[i]);
+  return result;
+}
+
+} // namespace bf
@@ -1,6 +1,8 @@
 #include <bf/bloom_filter/a2.hpp>
 
+#include <algorithm>
 #include <cassert>
+#include <stdexcept>
 
 namespace bf {
 
@@ -42,4 +44,34 @@ void a2_bloom_filter::clear() {
   second_.clear();
 }
 
+void a2_bloom_filter::merge(a2_bloom_filter const& other) {
+  auto cross = crossed(other);
+  first_.merge(cross ? other.second_ : other.first_);
+  second_.merge(cross ? other.first_ : other.second_);
+  // A full passive half may have joined the active half.
+  items_ = std::min(items_ + (cross ? capacity_ : other.items_), capacity_);
+}
+
+void a2_bloom_filter::intersect(a2_bloom_filter const& other) {
+  auto cross = crossed(other);
+  first_.intersect(cross ? other.second_ : other.first_);
+  second_.intersect(cross ? other.first_ : other.second_);
+  if (!cross)
+    items_ = std::min(items_, other.items_);
+}
+
+size_t a2_bloom_filter::bits() const {
+  return first_.storage().size() + second_.storage().size();
+}
+
+bool a2_bloom_filter::crossed(a2_bloom_filter const& other) const {
+  if (capacity_ == other.capacity_) {
+    if (first_.compatible(other.first_) && second_.compatible(other.second_))
+      return false;
+    if (first_.compatible(other.second_) && second_.compatible(other.first_))
+      return true;
+  }
+  throw std::invalid_argument("cannot combine incompatible A2 filters");
+}
+
 } // namespace bf
@@ -0,0 +1,186 @@
+#include <bf/bloom_filter/age_partitioned.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace bf {
+
+namespace {
+
+size_t const max_k = 32;
+
+// Finds the smallest slice size that satisfies a false-positive rate.
+size_t min_cells(double fp, size_t k, size_t l, size_t generation) {
+  // Start at a fill ratio of about 1/2 in the oldest slices.
+  size_t lo = 1;
+  size_t hi = k * generation;
+  while (age_partitioned_bloom_filter::fp_rate(k, l, hi, generation) > fp) {
+    lo = hi + 1;
+    hi *= 2;
+  }
+  while (lo < hi) {
+    auto mid = lo + (hi - lo) / 2;
+    if (age_partitioned_bloom_filter::fp_rate(k, l, mid, generation) > fp)
+      lo = mid + 1;
+    else
+      hi = mid;
+  }
+  return hi;
+}
+
+} // namespace <anonymous>
+
+double age_partitioned_bloom_filter::fp_rate(size_t k, size_t l, size_t cells,
+                                             size_t generation) {
+  // At the end of a generation, the slice of age a has received
+  // min(a + 1, k) generations of insertions. A dynamic program over the
+  // slices computes the probability of a run of k set bits, where run[r] is
+  // the probability of a current run of length r without an earlier run of
+  // length k.
+  std::vector<double> run(k, 0.0);
+  run[0] = 1;
+  double hit = 0;
+  for (size_t age = 0; age < k + l; ++age) {
+    auto n = static_cast<double>(std::min(age + 1, k) * generation);
+    auto fill = -std::expm1(-n / cells);
+    hit += run[k - 1] * fill;
+    double miss = 0;
+    for (size_t r = k - 1; r > 0; --r) {
+      miss += run[r];
+      run[r] = run[r - 1] * fill;
+    }
+    miss += run[0];
+    run[0] = miss * (1 - fill);
+  }
+  return hit;
+}
+
+age_partitioned_bloom_filter::age_partitioned_bloom_filter(size_t k, size_t l,
+                                                           size_t cells,
+                                                           size_t generation,
+                                                           size_t seed)
+    : k_(k),
+      l_(l),
+      cells_(cells),
+      generation_(generation),
+      hash_(seed),
+      slices_(k + l, bitvector(cells)) {
+  assert(k > 0);
+  assert(l > 0);
+  assert(cells > 0);
+  assert(generation > 0);
+}
+
+age_partitioned_bloom_filter::age_partitioned_bloom_filter(double fp,
+                                                           size_t window,
+                                                           size_t seed)
+    : hash_(seed) {
+  assert(fp > 0 && fp < 1);
+  assert(window > 0);
+  // Shorter generations require fewer bits per slice but more slices. The
+  // total size is roughly unimodal in both k and l, so the search stops once
+  // the size grows consistently. Bounding l by 4k limits the number of
+  // slices a lookup may probe at a space overhead of a few percent.
+  size_t const patience = 3;
+  auto best = std::numeric_limits<size_t>::max();
+  for (size_t k = 1, worse_k = 0; k <= max_k && worse_k < patience; ++k) {
+    auto best_k = std::numeric_limits<size_t>::max();
+    for (size_t l = 1, worse_l = 0; l <= 4 * k && worse_l < patience;
+         ++l) {
+      auto generation = (window + l - 1) / l;
+      auto cells = min_cells(fp, k, l, generation);
+      auto bits = (k + l) * cells;
+      worse_l = bits < best_k ? 0 : worse_l + 1;
+      best_k = std::min(bits, best_k);
+      if (bits < best) {
+        best = bits;
+        k_ = k;
+        l_ = l;
+        cells_ = cells;
+        generation_ = generation;
+      }
+    }
+    worse_k = best_k > best ? worse_k + 1 : 0;
+  }
+  slices_.assign(k_ + l_, bitvector(cells_));
+}
+
+void age_partitioned_bloom_filter::add(object const& o) {
+  if (count_ == generation_)
+    rotate();
+  ++count_;
+  auto d = hash_(o);
+  for (size_t age = 0; age < k_; ++age) {
+    auto s = physical(age);
+    slices_[s].set(index(d, s));
+  }
+}
+
+size_t age_partitioned_bloom_filter::lookup(object const& o) const {
+  auto d = hash_(o);
+  auto n = k_ + l_;
+  size_t run = 0;
+  for (size_t age = 0; age < n; ++age) {
+    auto s = physical(age);
+    if (slices_[s][index(d, s)]) {
+      if (++run == k_)
+        return 1;
+    } else {
+      // Too few slices remain for a run of length k.
+      if (n - age - 1 < k_)
+        return 0;
+      run = 0;
+    }
+  }
+  return 0;
+}
+
+void age_partitioned_bloom_filter::clear() {
+  for (auto& s : slices_)
+    s.reset();
+  newest_ = 0;
+  count_ = 0;
+}
+
+void age_partitioned_bloom_filter::rotate() {
+  newest_ = (newest_ + 1) % slices_.size();
+  slices_[newest_].reset();
+  count_ = 0;
+}
+
+size_t age_partitioned_bloom_filter::k() const {
+  return k_;
+}
+
+size_t age_partitioned_bloom_filter::l() const {
+  return l_;
+}
+
+size_t age_partitioned_bloom_filter::cells() const {
+  return cells_;
+}
+
+size_t age_partitioned_bloom_filter::generation() const {
+  return generation_;
+}
+
+size_t age_partitioned_bloom_filter::window() const {
+  return l_ * generation_;
+}
+
+size_t age_partitioned_bloom_filter::index(digest d, size_t slice) const {
+  // Plain double hashing correlates the bits of two keys across all slices
+  // once both halves of their digests collide modulo the slice size, which
+  // noticeably inflates the false-positive rate of small slices. Mixing the
+  // digest with the slice position avoids this at the cost of two
+  // multiplications.
+  auto h = murmur64(d + (slice + 1) * 0x9e3779b97f4a7c15ULL);
+  return (static_cast<unsigned __int128>(h) * cells_) >> 64;
+}
+
+size_t age_partitioned_bloom_filter::physical(size_t age) const {
+  return (newest_ + slices_.size() - age) % slices_.size();
+}
+
+} // namespace bf
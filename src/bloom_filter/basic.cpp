@@ -1,10 +1,44 @@
 #include <bf/bloom_filter/basic.hpp>
 
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <bf/bulk.hpp>
+#include <bf/serialization.hpp>
 
 namespace bf {
 
+namespace {
+
+double estimate(size_t cells, size_t k, size_t ones) {
+  if (ones >= cells)
+    return std::numeric_limits<double>::infinity();
+  auto m = static_cast<double>(cells);
+  return -m / k * std::log1p(-(ones / m));
+}
+
+typedef bitvector::block_type block_type;
+
+// Combines two bit vectors of equal size block by block in place and counts
+// the 1-bits of the result in the same pass. The iterations are independent,
+// so that the compiler vectorizes the loop.
+template <typename Op>
+size_t combine(bitvector& x, bitvector const& y, Op op) {
+  auto xs = x.data();
+  auto ys = y.data();
+  size_t ones = 0;
+  for (size_t i = 0; i < x.blocks(); ++i) {
+    xs[i] = op(xs[i], ys[i]);
+    ones += __builtin_popcountll(xs[i]);
+  }
+  return ones;
+}
+
+} // namespace <anonymous>
+
 size_t basic_bloom_filter::m(double fp, size_t capacity) {
   auto ln2 = std::log(2);
   return std::ceil(-(capacity * std::log(fp) / ln2 / ln2));
@@ -16,7 +50,10 @@ size_t basic_bloom_filter::k(size_t cells, size_t capacity) {
 }
 
 basic_bloom_filter::basic_bloom_filter(hasher h, size_t cells, bool partition)
-    : hasher_(std::move(h)), bits_(cells), partition_(partition) {
+    : hasher_(std::move(h)),
+      fingerprint_(fingerprint(hasher_)),
+      bits_(cells),
+      partition_(partition) {
 }
 
 basic_bloom_filter::basic_bloom_filter(double fp, size_t capacity, size_t seed,
@@ -28,66 +65,241 @@ basic_bloom_filter::basic_bloom_filter(double fp, size_t capacity, size_t seed,
     required_cells += optimal_k - required_cells % optimal_k;
   bits_.resize(required_cells);
   hasher_ = make_hasher(optimal_k, seed, double_hashing);
+  fingerprint_ = fingerprint(hasher_);
 }
 
-basic_bloom_filter::basic_bloom_filter(hasher h, bitvector b)
-    : hasher_(std::move(h)), bits_(std::move(b)) {
+basic_bloom_filter::basic_bloom_filter(hasher h, bitvector b, bool partition)
+    : hasher_(std::move(h)),
+      fingerprint_(fingerprint(hasher_)),
+      bits_(std::move(b)),
+      partition_(partition),
+      ones_(bits_.count()) {
 }
 
 basic_bloom_filter::basic_bloom_filter(basic_bloom_filter&& other)
-    : hasher_(std::move(other.hasher_)), bits_(std::move(other.bits_)) {
+    : hasher_(std::move(other.hasher_)),
+      fingerprint_(other.fingerprint_),
+      bits_(std::move(other.bits_)),
+      partition_(other.partition_),
+      ones_(other.ones_),
+      events_(std::move(other.events_)) {
+}
+
+basic_bloom_filter basic_bloom_filter::load(std::istream& in) {
+  auto buffer = slurp(in);
+  return deserialize(buffer->data(), buffer->size(), nullptr);
+}
+
+basic_bloom_filter basic_bloom_filter::load(std::string const& filename) {
+  mapped_file file{filename};
+  return deserialize(file.data(), file.size(), nullptr);
+}
+
+basic_bloom_filter basic_bloom_filter::load(std::istream& in, hasher h) {
+  auto buffer = slurp(in);
+  return deserialize(buffer->data(), buffer->size(), &h);
 }
 
 void basic_bloom_filter::add(object const& o) {
-  auto digests = hasher_(o);
-  if (partition_) {
-    assert(bits_.size() % digests.size() == 0);
-    auto parts = bits_.size() / digests.size();
-    for (size_t i = 0; i < digests.size(); ++i)
-      bits_.set(i * parts + (digests[i] % parts));
-  } else {
-    for (auto d : digests)
-      bits_.set(d % bits_.size());
-  }
+  events_.record(event::add);
+  for (auto i : find_indices(o))
+    if (!bits_[i]) {
+      bits_.set(i);
+      ++ones_;
+    }
 }
 
 size_t basic_bloom_filter::lookup(object const& o) const {
-  auto digests = hasher_(o);
-  if (partition_) {
-    assert(bits_.size() % digests.size() == 0);
-    auto parts = bits_.size() / digests.size();
-    for (size_t i = 0; i < digests.size(); ++i)
-      if (!bits_[i * parts + (digests[i] % parts)])
-        return 0;
-  } else {
-    for (auto d : digests)
-      if (!bits_[d % bits_.size()])
-        return 0;
-  }
-
+  events_.record(event::lookup);
+  for (auto i : find_indices(o))
+    if (!bits_[i])
+      return 0;
   return 1;
 }
 
 void basic_bloom_filter::clear() {
   bits_.reset();
+  ones_ = 0;
+}
+
+bool basic_bloom_filter::compatible(basic_bloom_filter const& other) const {
+  return bits_.size() == other.bits_.size()
+         && partition_ == other.partition_
+         && fingerprint_ == other.fingerprint_;
+}
+
+void basic_bloom_filter::merge(basic_bloom_filter const& other) {
+  if (!compatible(other))
+    throw std::invalid_argument("cannot merge incompatible filters");
+  ones_ = combine(bits_, other.bits_,
+                  [](block_type x, block_type y) { return x | y; });
+}
+
+void basic_bloom_filter::intersect(basic_bloom_filter const& other) {
+  if (!compatible(other))
+    throw std::invalid_argument("cannot intersect incompatible filters");
+  ones_ = combine(bits_, other.bits_,
+                  [](block_type x, block_type y) { return x & y; });
 }
 
 void basic_bloom_filter::remove(object const& o) {
-  for (auto d : hasher_(o))
-    bits_.reset(d % bits_.size());
+  events_.record(event::remove);
+  for (auto i : find_indices(o))
+    if (bits_[i]) {
+      bits_.reset(i);
+      --ones_;
+    }
+}
+
+void basic_bloom_filter::bulk_add(std::function<object(size_t)> const& element,
+                                  size_t n, size_t threads) {
+  // Regions of 256 KiB fit into the L2 cache.
+  static size_t const region_cells = 1 << 21;
+  auto indices = [&](size_t i, std::vector<size_t>& out) {
+    auto cells = find_indices(element(i));
+    out.insert(out.end(), cells.begin(), cells.end());
+  };
+  // Each region tallies the bits it flips, so that the total number of ones
+  // stays exact without recounting the whole vector.
+  std::atomic<size_t> flipped{0};
+  auto apply = [&](size_t const* cells, size_t count) {
+    size_t ones = 0;
+    for (size_t i = 0; i < count; ++i)
+      if (!bits_[cells[i]]) {
+        bits_.set(cells[i]);
+        ++ones;
+      }
+    if (ones > 0)
+      flipped += ones;
+  };
+  bulk_update(n, bits_.size(), region_cells, threads, indices, apply);
+  ones_ += flipped;
+  events_.record(event::add, n);
+}
+
+double basic_bloom_filter::estimated_cardinality() const {
+  return estimate(bits_.size(), hash_count(), ones_);
+}
+
+double
+basic_bloom_filter::estimated_union(basic_bloom_filter const& other) const {
+  if (!compatible(other))
+    throw std::invalid_argument("cannot estimate the union of incompatible "
+                                "filters");
+  size_t x, y, both;
+  count_joint(bits_, other.bits_, x, y, both);
+  return estimate(bits_.size(), hash_count(), x + y - both);
+}
+
+double basic_bloom_filter::estimated_intersection(
+  basic_bloom_filter const& other) const {
+  if (!compatible(other))
+    throw std::invalid_argument("cannot estimate the intersection of "
+                                "incompatible filters");
+  size_t x, y, both;
+  count_joint(bits_, other.bits_, x, y, both);
+  auto k = hash_count();
+  auto n = estimate(bits_.size(), k, x) + estimate(bits_.size(), k, y)
+           - estimate(bits_.size(), k, x + y - both);
+  return n > 0 ? n : 0;
+}
+
+filter_metrics basic_bloom_filter::metrics() const {
+  filter_metrics m;
+  m.cells = bits_.size();
+  m.hash_functions = hash_count();
+  m.nonzero = ones_;
+  m.adds = events_.total(event::add);
+  m.lookups = events_.total(event::lookup);
+  m.removes = events_.total(event::remove);
+  return m;
+}
+
+void basic_bloom_filter::save(std::ostream& out) const {
+  write_header(out, serialization_tag::basic_bloom_filter);
+  write_descriptor(out, descriptor());
+  write<uint64_t>(out, fingerprint_);
+  write<uint64_t>(out, bits_.size());
+  out.write(reinterpret_cast<char const*>(bits_.data()),
+            bits_.blocks() * sizeof(bitvector::block_type));
 }
 
 void basic_bloom_filter::swap(basic_bloom_filter& other) {
   using std::swap;
   swap(hasher_, other.hasher_);
+  swap(fingerprint_, other.fingerprint_);
   swap(bits_, other.bits_);
+  swap(partition_, other.partition_);
+  swap(ones_, other.ones_);
+  swap(events_, other.events_);
 }
 
 bitvector const& basic_bloom_filter::storage() const {
   return bits_;
 }
+
 hasher const& basic_bloom_filter::hasher_function() const {
   return hasher_;
 }
 
+bool basic_bloom_filter::partitioned() const {
+  return partition_;
+}
+
+hasher_descriptor basic_bloom_filter::descriptor() const {
+  auto d = describe(hasher_);
+  d.mapping = partition_ ? hasher_descriptor::partitioned
+                         : hasher_descriptor::modulo;
+  return d;
+}
+
+basic_bloom_filter basic_bloom_filter::deserialize(void const* data,
+                                                   size_t size,
+                                                   hasher const* h) {
+  reader source{data, size};
+  source.read_header(serialization_tag::basic_bloom_filter);
+  auto d = read_descriptor(source);
+  auto id = source.read<uint64_t>();
+  auto cells = source.read<uint64_t>();
+  if (!h && d.family == hasher_descriptor::custom)
+    throw std::runtime_error("filter has a custom hasher");
+  // Validate the header before allocating anything it describes.
+  auto bytes = cell_bytes(source, cells);
+  auto k = h ? (*h)(object{nullptr, 0}).size() : d.k;
+  if (k == 0 || k > cells)
+    throw std::runtime_error("invalid number of hash functions");
+  bitvector bits(cells);
+  std::memcpy(bits.data(), source.skip(bytes), bytes);
+  auto partition = d.mapping == hasher_descriptor::partitioned;
+  basic_bloom_filter filter{h ? *h : make_hasher(d), std::move(bits),
+                            partition};
+  if (filter.fingerprint_ != id)
+    throw std::runtime_error("hasher does not match the serialized filter");
+  return filter;
+}
+
+size_t basic_bloom_filter::hash_count() const {
+  // Hashers produce a fixed number of digests per object.
+  return hasher_(object{nullptr, 0}).size();
+}
+
+std::vector<size_t> basic_bloom_filter::find_indices(object const& o) const {
+  auto indices = hasher_(o);
+  map_indices(indices, bits_.size(), partition_);
+  return indices;
+}
+
+void basic_bloom_filter::map_indices(std::vector<size_t>& digests,
+                                     size_t cells, bool partition) {
+  if (partition) {
+    assert(cells % digests.size() == 0);
+    auto parts = cells / digests.size();
+    for (size_t i = 0; i < digests.size(); ++i)
+      digests[i] = i * parts + (digests[i] % parts);
+  } else {
+    for (auto& i : digests)
+      i %= cells;
+  }
+}
+
 } // namespace bf
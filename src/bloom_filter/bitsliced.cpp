@@ -0,0 +1,87 @@
+#include <bf/bloom_filter/bitsliced.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace bf {
+
+bitsliced_index::bitsliced_index(hasher h, size_t cells, bool partition)
+    : hasher_(std::move(h)), cells_(cells), partition_(partition) {
+  assert(cells > 0);
+}
+
+bitsliced_index::bitsliced_index(basic_bloom_filter const& prototype)
+    : bitsliced_index(prototype.hasher_function(), prototype.storage().size(),
+                      prototype.partitioned()) {
+}
+
+size_t bitsliced_index::add(basic_bloom_filter const& filter) {
+  auto& bits = filter.storage();
+  if (bits.size() != cells_ || filter.partitioned() != partition_)
+    throw std::invalid_argument("filter geometry differs from index");
+  reserve(size_ + 1);
+  auto word = size_ / 64;
+  auto mask = uint64_t(1) << (size_ % 64);
+  for (auto i = bits.find_first(); i != bitvector::npos; i = bits.find_next(i))
+    rows_[i * stride_ + word] |= mask;
+  return size_++;
+}
+
+void bitsliced_index::add(size_t filter, object const& o) {
+  assert(filter < size_);
+  auto indices = hasher_(o);
+  basic_bloom_filter::map_indices(indices, cells_, partition_);
+  for (auto i : indices)
+    rows_[i * stride_ + filter / 64] |= uint64_t(1) << (filter % 64);
+}
+
+bitvector bitsliced_index::lookup(object const& o) const {
+  std::vector<uint64_t> result(stride_, ~uint64_t(0));
+  auto indices = hasher_(o);
+  basic_bloom_filter::map_indices(indices, cells_, partition_);
+  for (auto i : indices) {
+    // The loop has no dependencies across words and vectorizes.
+    auto row = rows_.data() + i * stride_;
+    uint64_t any = 0;
+    for (size_t w = 0; w < stride_; ++w) {
+      result[w] &= row[w];
+      any |= result[w];
+    }
+    if (any == 0)
+      break;
+  }
+  bitvector candidates(result.begin(), result.end());
+  candidates.resize(size_);
+  return candidates;
+}
+
+void bitsliced_index::clear() {
+  size_ = 0;
+  stride_ = 0;
+  rows_.clear();
+}
+
+size_t bitsliced_index::size() const {
+  return size_;
+}
+
+size_t bitsliced_index::cells() const {
+  return cells_;
+}
+
+void bitsliced_index::reserve(size_t filters) {
+  auto words = (filters + 63) / 64;
+  if (words <= stride_)
+    return;
+  // Double the row width to amortize the transposition.
+  auto stride = std::max(words, 2 * stride_);
+  std::vector<uint64_t> rows(cells_ * stride);
+  for (size_t i = 0; i < cells_; ++i)
+    std::copy(rows_.begin() + i * stride_, rows_.begin() + (i + 1) * stride_,
+              rows.begin() + i * stride);
+  rows_.swap(rows);
+  stride_ = stride;
+}
+
+} // namespace bf
@@ -34,6 +34,13 @@ void bitwise_bloom_filter::clear() {
   grow();
 }
 
+size_t bitwise_bloom_filter::bits() const {
+  size_t n = 0;
+  for (auto& level : levels_)
+    n += level.storage().size();
+  return n;
+}
+
 void bitwise_bloom_filter::grow() {
   auto l = levels_.size();
 
@@ -0,0 +1,206 @@
+#include <bf/bloom_filter/count_min.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <functional>
+
+namespace bf {
+
+namespace {
+
+// The number of elements whose counters a batch update prefetches before
+// updating any of them.
+size_t const prefetch_group = 16;
+
+} // namespace <anonymous>
+
+size_t count_min_sketch::width(double epsilon) {
+  assert(epsilon > 0);
+  return std::ceil(std::exp(1.0) / epsilon);
+}
+
+size_t count_min_sketch::depth(double delta) {
+  assert(delta > 0 && delta < 1);
+  auto d = std::ceil(std::log(1 / delta));
+  return d < 1 ? 1 : static_cast<size_t>(d);
+}
+
+count_min_sketch::count_min_sketch(size_t width, size_t depth,
+                                   size_t counter_width, size_t seed,
+                                   bool conservative)
+    : hasher_(make_hasher(depth, seed)),
+      rows_(depth, counter_vector(width, counter_width)),
+      seed_(seed),
+      conservative_(conservative) {
+  assert(width > 0);
+  assert(depth > 0);
+  assert(counter_width > 0 && counter_width <= 64);
+}
+
+void count_min_sketch::add(object const& o) {
+  add(o, 1);
+}
+
+void count_min_sketch::add(object const& o, size_t count) {
+  if (count > 0)
+    update(o, find_indices(o), count);
+}
+
+void count_min_sketch::add(std::vector<object> const& os) {
+  std::vector<std::vector<size_t>> indices(prefetch_group);
+  for (size_t first = 0; first < os.size(); first += prefetch_group) {
+    auto last = std::min(first + prefetch_group, os.size());
+    for (auto i = first; i < last; ++i) {
+      auto& idx = indices[i - first];
+      idx = find_indices(os[i]);
+      for (size_t r = 0; r < rows_.size(); ++r)
+        rows_[r].prefetch(idx[r]);
+    }
+    for (auto i = first; i < last; ++i)
+      update(os[i], indices[i - first], 1);
+  }
+}
+
+size_t count_min_sketch::lookup(object const& o) const {
+  return find_minimum(find_indices(o));
+}
+
+void count_min_sketch::clear() {
+  for (auto& row : rows_)
+    row.clear();
+  total_ = 0;
+  heap_.clear();
+}
+
+void count_min_sketch::merge(count_min_sketch const& other) {
+  assert(rows_.size() == other.rows_.size());
+  assert(width() == other.width());
+  assert(seed_ == other.seed_);
+  for (size_t r = 0; r < rows_.size(); ++r)
+    rows_[r] |= other.rows_[r];
+  total_ = std::max(total_ + other.total_, total_);
+  if (k_ == 0)
+    return;
+  // Re-estimate the candidates of both sketches against the merged counters.
+  auto candidates = std::move(heap_);
+  candidates.insert(candidates.end(), other.heap_.begin(), other.heap_.end());
+  heap_.clear();
+  for (auto& c : candidates)
+    offer(std::move(c.second), count_min_sketch::lookup(wrap(c.second)));
+}
+
+void count_min_sketch::track(size_t k) {
+  k_ = k;
+  std::sort(heap_.begin(), heap_.end(), std::greater<hitter>());
+  if (heap_.size() > k_)
+    heap_.resize(k_);
+  std::make_heap(heap_.begin(), heap_.end(), std::greater<hitter>());
+}
+
+std::vector<std::pair<std::string, size_t>>
+count_min_sketch::heavy_hitters() const {
+  std::vector<std::pair<std::string, size_t>> result;
+  for (auto& h : heap_)
+    result.emplace_back(h.second, lookup(wrap(h.second)));
+  std::sort(result.begin(), result.end(),
+            [](std::pair<std::string, size_t> const& x,
+               std::pair<std::string, size_t> const& y) {
+              return x.second > y.second;
+            });
+  return result;
+}
+
+size_t count_min_sketch::total() const {
+  return total_;
+}
+
+size_t count_min_sketch::width() const {
+  return rows_[0].size();
+}
+
+size_t count_min_sketch::depth() const {
+  return rows_.size();
+}
+
+std::vector<size_t> count_min_sketch::find_indices(object const& o) const {
+  auto indices = hasher_(o);
+  auto w = width();
+  for (auto& i : indices)
+    i %= w;
+  return indices;
+}
+
+size_t
+count_min_sketch::find_minimum(std::vector<size_t> const& indices) const {
+  auto min = rows_[0].count(indices[0]);
+  for (size_t r = 1; r < rows_.size(); ++r)
+    min = std::min(min, rows_[r].count(indices[r]));
+  return min;
+}
+
+void count_min_sketch::update(object const& o,
+                              std::vector<size_t> const& indices,
+                              size_t count) {
+  total_ = std::max(total_ + count, total_);
+  if (conservative_) {
+    auto min = find_minimum(indices);
+    auto target = std::max(min + count, min);
+    for (size_t r = 0; r < rows_.size(); ++r) {
+      auto& row = rows_[r];
+      if (row.count(indices[r]) < target)
+        row.set(indices[r], std::min(target, row.max()));
+    }
+  } else {
+    for (size_t r = 0; r < rows_.size(); ++r)
+      rows_[r].increment(indices[r], count);
+  }
+  if (k_ > 0)
+    offer(std::string(static_cast<char const*>(o.data()), o.size()),
+          find_minimum(indices));
+}
+
+void count_min_sketch::offer(std::string key, size_t estimate) {
+  // The heap holds few elements, so a linear scan beats an auxiliary index.
+  for (auto& h : heap_)
+    if (h.second == key) {
+      h.first = estimate;
+      std::make_heap(heap_.begin(), heap_.end(), std::greater<hitter>());
+      return;
+    }
+  if (heap_.size() < k_) {
+    heap_.emplace_back(estimate, std::move(key));
+    std::push_heap(heap_.begin(), heap_.end(), std::greater<hitter>());
+  } else if (estimate > heap_.front().first) {
+    std::pop_heap(heap_.begin(), heap_.end(), std::greater<hitter>());
+    heap_.back() = {estimate, std::move(key)};
+    std::push_heap(heap_.begin(), heap_.end(), std::greater<hitter>());
+  }
+}
+
+count_mean_min_sketch::count_mean_min_sketch(size_t width, size_t depth,
+                                             size_t counter_width, size_t seed)
+    : count_min_sketch(width, depth, counter_width, seed, false) {
+  assert(width > 1);
+}
+
+size_t count_mean_min_sketch::lookup(object const& o) const {
+  auto indices = find_indices(o);
+  auto w = static_cast<double>(width());
+  std::vector<double> estimates(rows_.size());
+  for (size_t r = 0; r < rows_.size(); ++r) {
+    auto c = static_cast<double>(rows_[r].count(indices[r]));
+    estimates[r] = c - (total_ - c) / (w - 1);
+  }
+  auto mid = estimates.begin() + estimates.size() / 2;
+  std::nth_element(estimates.begin(), mid, estimates.end());
+  auto median = *mid;
+  if (estimates.size() % 2 == 0)
+    median = (median + *std::max_element(estimates.begin(), mid)) / 2;
+  if (median <= 0)
+    return 0;
+  return std::min(static_cast<size_t>(std::round(median)),
+                  find_minimum(indices));
+}
+
+} // namespace bf
@@ -1,20 +1,62 @@
 #include <bf/bloom_filter/counting.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cstring>
+#include <stdexcept>
+#include <bf/bulk.hpp>
+#include <bf/serialization.hpp>
 
 namespace bf {
 
 counting_bloom_filter::counting_bloom_filter(hasher h, size_t cells,
                                              size_t width, bool partition)
-    : hasher_(std::move(h)), cells_(cells, width), partition_(partition) {
+    : hasher_(std::move(h)),
+      fingerprint_(fingerprint(hasher_)),
+      cells_(cells, width),
+      partition_(partition) {
+}
+
+counting_bloom_filter::counting_bloom_filter(hasher h, counter_vector cells,
+                                             bool partition)
+    : hasher_(std::move(h)),
+      fingerprint_(fingerprint(hasher_)),
+      cells_(std::move(cells)),
+      partition_(partition),
+      nonzero_(cells_.size() - cells_.count_equal(0, cells_.size(), 0)),
+      saturated_(cells_.count_equal(0, cells_.size(), cells_.max())) {
+}
+
+counting_bloom_filter counting_bloom_filter::load(std::istream& in) {
+  auto buffer = slurp(in);
+  return deserialize(buffer->data(), buffer->size());
+}
+
+counting_bloom_filter
+counting_bloom_filter::load(std::string const& filename) {
+  mapped_file file{filename};
+  return deserialize(file.data(), file.size());
+}
+
+void counting_bloom_filter::save(std::ostream& out) const {
+  write_header(out, serialization_tag::counting_bloom_filter);
+  write_descriptor(out, descriptor());
+  write<uint64_t>(out, fingerprint_);
+  write<uint64_t>(out, cells_.size());
+  write<uint64_t>(out, cells_.width());
+  auto& bits = cells_.bits();
+  out.write(reinterpret_cast<char const*>(bits.data()),
+            bits.blocks() * sizeof(bitvector::block_type));
 }
 
 void counting_bloom_filter::add(object const& o) {
+  events_.record(event::add);
   increment(find_indices(o));
 }
 
 size_t counting_bloom_filter::lookup(object const& o) const {
+  events_.record(event::lookup);
   auto min = cells_.max();
   for (auto i : find_indices(o)) {
     auto cnt = cells_.count(i);
@@ -26,12 +68,139 @@ size_t counting_bloom_filter::lookup(object const& o) const {
 
 void counting_bloom_filter::clear() {
   cells_.clear();
+  nonzero_ = 0;
+  saturated_ = 0;
 }
 
 void counting_bloom_filter::remove(object const& o) {
+  events_.record(event::remove);
   decrement(find_indices(o));
 }
 
+counting_bloom_filter counting_bloom_filter::deserialize(void const* data,
+                                                         size_t size) {
+  reader source{data, size};
+  source.read_header(serialization_tag::counting_bloom_filter);
+  auto d = read_descriptor(source);
+  auto id = source.read<uint64_t>();
+  auto cells = source.read<uint64_t>();
+  auto width = source.read<uint64_t>();
+  if (d.family == hasher_descriptor::custom)
+    throw std::runtime_error("filter has a custom hasher");
+  // Validate the header before allocating anything it describes.
+  auto bytes = cell_bytes(source, cells, width);
+  if (d.k == 0 || d.k > cells)
+    throw std::runtime_error("invalid number of hash functions");
+  bitvector bits(cells * width);
+  std::memcpy(bits.data(), source.skip(bytes), bytes);
+  auto partition = d.mapping == hasher_descriptor::partitioned;
+  counting_bloom_filter filter{make_hasher(d),
+                               counter_vector{std::move(bits), width},
+                               partition};
+  if (filter.fingerprint_ != id)
+    throw std::runtime_error("hasher does not match the serialized filter");
+  return filter;
+}
+
+void counting_bloom_filter::bulk_add(
+  std::function<object(size_t)> const& element, size_t n, size_t threads) {
+  // Regions of about 256 KiB fit into the L2 cache. Since a region spans a
+  // multiple of 64 counters, it ends at a block boundary.
+  auto blocks = std::max<size_t>((1 << 21) / cells_.width() / 64, 1);
+  auto region_cells = blocks * 64;
+  // Each region tallies the counters that leave zero or reach the maximum,
+  // which keeps the occupancy exact without recounting all counters.
+  std::atomic<size_t> overflows{0};
+  std::atomic<size_t> nonzero{0};
+  std::atomic<size_t> saturated{0};
+  auto indices = [&](size_t i, std::vector<size_t>& out) {
+    auto cells = find_indices(element(i));
+    out.insert(out.end(), cells.begin(), cells.end());
+  };
+  auto apply = [&](size_t const* cells, size_t count) {
+    size_t full = 0, started = 0, filled = 0;
+    for (size_t i = 0; i < count; ++i) {
+      auto before = cells_.count(cells[i]);
+      if (before == cells_.max()) {
+        ++full;
+        continue;
+      }
+      cells_.increment(cells[i]);
+      started += before == 0;
+      filled += before + 1 == cells_.max();
+    }
+    if (full > 0)
+      overflows += full;
+    if (started > 0)
+      nonzero += started;
+    if (filled > 0)
+      saturated += filled;
+  };
+  bulk_update(n, cells_.size(), region_cells, threads, indices, apply);
+  nonzero_ += nonzero;
+  saturated_ += saturated;
+  events_.record(event::add, n);
+  if (overflows > 0)
+    events_.record(event::overflow, overflows);
+}
+
+bool counting_bloom_filter::compatible(
+  counting_bloom_filter const& other) const {
+  return cells_.size() == other.cells_.size()
+         && cells_.width() == other.cells_.width()
+         && partition_ == other.partition_
+         && fingerprint_ == other.fingerprint_;
+}
+
+void counting_bloom_filter::merge(counting_bloom_filter const& other) {
+  if (!compatible(other))
+    throw std::invalid_argument("cannot merge incompatible filters");
+  cells_.add_range(other.cells_, 0, cells_.size());
+  nonzero_ = cells_.size() - cells_.count_equal(0, cells_.size(), 0);
+  saturated_ = cells_.count_equal(0, cells_.size(), cells_.max());
+}
+
+void counting_bloom_filter::intersect(counting_bloom_filter const& other) {
+  if (!compatible(other))
+    throw std::invalid_argument("cannot intersect incompatible filters");
+  cells_.min_range(other.cells_, 0, cells_.size());
+  nonzero_ = cells_.size() - cells_.count_equal(0, cells_.size(), 0);
+  saturated_ = cells_.count_equal(0, cells_.size(), cells_.max());
+}
+
+filter_metrics counting_bloom_filter::metrics() const {
+  filter_metrics m;
+  m.cells = cells_.size();
+  m.hash_functions = hasher_(object{nullptr, 0}).size();
+  m.nonzero = nonzero_;
+  m.saturated = saturated_;
+  m.adds = events_.total(event::add);
+  m.lookups = events_.total(event::lookup);
+  m.removes = events_.total(event::remove);
+  m.overflows = events_.total(event::overflow);
+  m.underflows = events_.total(event::underflow);
+  return m;
+}
+
+counter_vector const& counting_bloom_filter::storage() const {
+  return cells_;
+}
+
+hasher const& counting_bloom_filter::hasher_function() const {
+  return hasher_;
+}
+
+bool counting_bloom_filter::partitioned() const {
+  return partition_;
+}
+
+hasher_descriptor counting_bloom_filter::descriptor() const {
+  auto d = describe(hasher_);
+  d.mapping = partition_ ? hasher_descriptor::partitioned
+                         : hasher_descriptor::modulo;
+  return d;
+}
+
 std::vector<size_t> counting_bloom_filter::find_indices(object const& o) const {
   auto digests = hasher_(o);
   std::vector<size_t> indices(digests.size());
@@ -79,20 +248,59 @@ counting_bloom_filter::find_minima(std::vector<size_t> const& indices) const {
 
 bool counting_bloom_filter::increment(std::vector<size_t> const& indices,
                                       size_t value) {
-  auto status = true;
-  for (auto i : indices)
+  size_t overflows = 0;
+  for (auto i : indices) {
+    auto before = cells_.count(i);
+    if (before == cells_.max()) {
+      ++overflows;
+      continue;
+    }
     if (!cells_.increment(i, value))
-      status = false;
-  return status;
+      ++overflows;
+    nonzero_ += before == 0;
+    saturated_ += cells_.count(i) == cells_.max();
+  }
+  if (overflows > 0)
+    events_.record(event::overflow, overflows);
+  return overflows == 0;
 }
 
 bool counting_bloom_filter::decrement(std::vector<size_t> const& indices,
                                       size_t value) {
-  auto status = true;
-  for (auto i : indices)
-    if (!cells_.decrement(i, value))
-      status = false;
-  return status;
+  size_t underflows = 0;
+  for (auto i : indices) {
+    auto before = cells_.count(i);
+    if (before == 0) {
+      ++underflows;
+      continue;
+    }
+    auto after = before > value ? before - value : 0;
+    if (before < value)
+      ++underflows;
+    cells_.set(i, after);
+    nonzero_ -= after == 0;
+    saturated_ -= before == cells_.max();
+  }
+  if (underflows > 0)
+    events_.record(event::underflow, underflows);
+  return underflows == 0;
+}
+
+void counting_bloom_filter::saturate(std::vector<size_t> const& indices) {
+  for (auto i : indices) {
+    auto before = cells_.count(i);
+    if (before == cells_.max())
+      continue;
+    cells_.set(i, cells_.max());
+    nonzero_ += before == 0;
+    ++saturated_;
+  }
+}
+
+void counting_bloom_filter::decrement_range(size_t first, size_t last) {
+  nonzero_ -= cells_.count_equal(first, last, 1);
+  saturated_ -= cells_.count_equal(first, last, cells_.max());
+  cells_.decrement_range(first, last);
 }
 
 size_t counting_bloom_filter::count(size_t index) const {
@@ -171,4 +379,10 @@ void spectral_rm_bloom_filter::remove(object const& o) {
     second_.decrement(indices2);
 }
 
+size_t spectral_rm_bloom_filter::bits() const {
+  auto& x = first_.storage();
+  auto& y = second_.storage();
+  return x.size() * x.width() + y.size() * y.width();
+}
+
 } // namespace bf
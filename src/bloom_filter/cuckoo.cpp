@@ -0,0 +1,164 @@
+#include <bf/bloom_filter/cuckoo.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace bf {
+
+constexpr size_t cuckoo_filter::bucket_size;
+constexpr size_t cuckoo_filter::max_kicks;
+constexpr size_t cuckoo_filter::stash_size;
+
+size_t cuckoo_filter::fingerprint_bits(double fp) {
+  auto bits = std::ceil(std::log2(2 * bucket_size / fp));
+  return bits < 1 ? 1 : bits > 32 ? 32 : static_cast<size_t>(bits);
+}
+
+size_t cuckoo_filter::buckets(size_t capacity) {
+  auto required = std::ceil(capacity / (bucket_size * 0.95));
+  size_t n = 1;
+  while (n < required)
+    n <<= 1;
+  return n;
+}
+
+cuckoo_filter::cuckoo_filter(hash_function h, size_t buckets,
+                             size_t fingerprint_bits, size_t seed)
+    : hash_(std::move(h)),
+      slots_(buckets * bucket_size, fingerprint_bits),
+      mask_(buckets - 1),
+      prng_(seed) {
+  assert(buckets > 0 && (buckets & (buckets - 1)) == 0);
+  assert(fingerprint_bits > 0 && fingerprint_bits <= 32);
+}
+
+cuckoo_filter::cuckoo_filter(double fp, size_t capacity, size_t seed)
+    : cuckoo_filter(default_hash_function(seed), buckets(capacity),
+                    fingerprint_bits(fp), seed) {
+}
+
+void cuckoo_filter::add(object const& o) {
+  if (stash_.size() == stash_size)
+    throw std::length_error("cuckoo filter full");
+  auto loc = locate(o);
+  auto i = loc.first;
+  auto f = loc.second;
+  ++size_;
+  if (insert(i, f) || insert(alternate(i, f), f))
+    return;
+  // Both buckets are full: relocate existing fingerprints until one of them
+  // finds a free slot in its alternate bucket.
+  if (prng_() & 1)
+    i = alternate(i, f);
+  for (size_t n = 0; n < max_kicks; ++n) {
+    auto victim = i * bucket_size + prng_() % bucket_size;
+    auto evicted = slots_.count(victim);
+    slots_.set(victim, f);
+    f = evicted;
+    i = alternate(i, f);
+    if (insert(i, f))
+      return;
+  }
+  stash_.emplace_back(i, f);
+}
+
+size_t cuckoo_filter::lookup(object const& o) const {
+  auto loc = locate(o);
+  auto i1 = loc.first;
+  auto i2 = alternate(i1, loc.second);
+  auto result = count(i1, loc.second);
+  if (i2 != i1)
+    result += count(i2, loc.second);
+  for (auto& entry : stash_)
+    if (entry.second == loc.second && (entry.first == i1 || entry.first == i2))
+      ++result;
+  return result;
+}
+
+void cuckoo_filter::clear() {
+  slots_.clear();
+  stash_.clear();
+  size_ = 0;
+}
+
+bool cuckoo_filter::remove(object const& o) {
+  auto loc = locate(o);
+  auto i1 = loc.first;
+  auto i2 = alternate(i1, loc.second);
+  if (!erase(i1, loc.second) && !erase(i2, loc.second)) {
+    auto found = false;
+    for (auto e = stash_.begin(); e != stash_.end(); ++e)
+      if (e->second == loc.second && (e->first == i1 || e->first == i2)) {
+        stash_.erase(e);
+        found = true;
+        break;
+      }
+    if (!found)
+      return false;
+  }
+  --size_;
+  // The freed slot may give a stashed victim its home back.
+  for (auto e = stash_.begin(); e != stash_.end();)
+    if (insert(e->first, e->second)
+        || insert(alternate(e->first, e->second), e->second))
+      e = stash_.erase(e);
+    else
+      ++e;
+  return true;
+}
+
+size_t cuckoo_filter::size() const {
+  return size_;
+}
+
+size_t cuckoo_filter::slots() const {
+  return slots_.size();
+}
+
+std::pair<size_t, size_t> cuckoo_filter::locate(object const& o) const {
+  auto d = hash_(o);
+  // The low bits select the bucket, the high bits the fingerprint. Zero
+  // denotes an empty slot and is thus not a valid fingerprint.
+  size_t f = (static_cast<uint64_t>(d) >> 32) & slots_.max();
+  if (f == 0)
+    f = 1;
+  return {d & mask_, f};
+}
+
+size_t cuckoo_filter::alternate(size_t bucket, size_t fingerprint) const {
+  // Partial-key cuckoo hashing: xor-ing with a hash of the fingerprint is an
+  // involution, so the alternate of the alternate is the original bucket.
+  return (bucket ^ (fingerprint * 0x5bd1e995)) & mask_;
+}
+
+bool cuckoo_filter::insert(size_t bucket, size_t fingerprint) {
+  auto first = bucket * bucket_size;
+  for (auto i = first; i < first + bucket_size; ++i)
+    if (slots_.count(i) == 0) {
+      slots_.set(i, fingerprint);
+      return true;
+    }
+  return false;
+}
+
+bool cuckoo_filter::erase(size_t bucket, size_t fingerprint) {
+  auto first = bucket * bucket_size;
+  for (auto i = first; i < first + bucket_size; ++i)
+    if (slots_.count(i) == fingerprint) {
+      slots_.set(i, 0);
+      return true;
+    }
+  return false;
+}
+
+size_t cuckoo_filter::count(size_t bucket, size_t fingerprint) const {
+  size_t n = 0;
+  auto first = bucket * bucket_size;
+  for (auto i = first; i < first + bucket_size; ++i)
+    if (slots_.count(i) == fingerprint)
+      ++n;
+  return n;
+}
+
+} // namespace bf
@@ -0,0 +1,115 @@
+#include <bf/bloom_filter/expiring.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+namespace bf {
+
+size_t expiring_bloom_filter::width(uint64_t generations) {
+  size_t w = 2;
+  while ((uint64_t(1) << w) < 2 * generations + 3)
+    ++w;
+  return w;
+}
+
+expiring_bloom_filter::expiring_bloom_filter(hasher h, size_t cells,
+                                             size_t width, uint64_t ttl,
+                                             uint64_t resolution)
+    : hasher_(std::move(h)),
+      cells_(cells, width),
+      ttl_((ttl + resolution - 1) / resolution),
+      resolution_(resolution) {
+  assert(resolution > 0);
+  assert(width < 64);
+  assert(2 * ttl_ + 2 <= cells_.max());
+}
+
+void expiring_bloom_filter::add(object const& o) {
+  for (auto d : hasher_(o))
+    cells_.set(d % cells_.size(), stamp_);
+}
+
+void expiring_bloom_filter::add(object const& o, uint64_t now) {
+  advance(now);
+  add(o);
+}
+
+size_t expiring_bloom_filter::lookup(object const& o) const {
+  for (auto d : hasher_(o)) {
+    auto stamp = cells_.count(d % cells_.size());
+    if (stamp == 0 || age(stamp) > ttl_)
+      return 0;
+  }
+  return 1;
+}
+
+size_t expiring_bloom_filter::lookup(object const& o, uint64_t now) {
+  advance(now);
+  return lookup(o);
+}
+
+void expiring_bloom_filter::clear() {
+  cells_.clear();
+  credit_ = 0;
+}
+
+void expiring_bloom_filter::advance(uint64_t now) {
+  auto generation = now / resolution_;
+  if (generation <= generation_)
+    return;
+  auto range = cells_.max();
+  if (generation - generation_ >= range) {
+    // All stamps are older than the TTL.
+    cells_.clear();
+    credit_ = 0;
+    generation_ = generation;
+    stamp_ = generation_ % range + 1;
+    return;
+  }
+  // Within this many generations, the cursor must visit every cell, so that
+  // no stamp can wrap around to an age of at most the TTL.
+  auto period = range - ttl_ - 2;
+  auto cells = cells_.size();
+  auto elapsed = generation - generation_;
+  // Sweep the cells of all elapsed generations at once, at most one full
+  // pass, which keeps the cost of a long idle gap independent of its length.
+  size_t n;
+  if (elapsed >= period
+      || elapsed > (std::numeric_limits<uint64_t>::max() - credit_) / cells) {
+    n = cells;
+    credit_ = 0;
+  } else {
+    credit_ += elapsed * cells;
+    n = std::min<uint64_t>(credit_ / period, cells);
+    credit_ %= period;
+  }
+  sweep(n, elapsed);
+  generation_ = generation;
+  stamp_ = generation_ % range + 1;
+}
+
+uint64_t expiring_bloom_filter::generation() const {
+  return generation_;
+}
+
+uint64_t expiring_bloom_filter::ttl() const {
+  return ttl_;
+}
+
+uint64_t expiring_bloom_filter::age(size_t stamp) const {
+  auto range = cells_.max();
+  return (stamp_ + range - stamp) % range;
+}
+
+void expiring_bloom_filter::sweep(size_t n, uint64_t elapsed) {
+  for (size_t i = 0; i < n; ++i) {
+    auto stamp = cells_.count(cursor_);
+    if (stamp != 0 && age(stamp) + elapsed > ttl_)
+      cells_.set(cursor_, 0);
+    if (++cursor_ == cells_.size())
+      cursor_ = 0;
+  }
+}
+
+} // namespace bf
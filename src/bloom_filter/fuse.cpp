@@ -0,0 +1,150 @@
+#include <bf/bloom_filter/fuse.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+#include <bf/serialization.hpp>
+
+namespace bf {
+
+namespace {
+
+uint64_t fingerprint(uint64_t h) {
+  return h ^ (h >> 32);
+}
+
+uint64_t load_fingerprint(unsigned char const* p, size_t width) {
+  return width == 1 ? p[0] : p[0] | (p[1] << 8);
+}
+
+void store_fingerprint(unsigned char* p, size_t width, uint64_t x) {
+  p[0] = x & 0xff;
+  if (width == 2)
+    p[1] = (x >> 8) & 0xff;
+}
+
+size_t const max_attempts = 100;
+
+} // namespace <anonymous>
+
+binary_fuse_filter::binary_fuse_filter(size_t fingerprint_bits, size_t seed)
+    : seed_(seed), hash_(seed), width_(fingerprint_bits / 8) {
+  if (fingerprint_bits != 8 && fingerprint_bits != 16)
+    throw std::invalid_argument("fingerprints must have 8 or 16 bits");
+}
+
+binary_fuse_filter binary_fuse_filter::load(std::istream& in) {
+  auto buffer = slurp(in);
+  return load(buffer->data(), buffer->size(), buffer);
+}
+
+binary_fuse_filter binary_fuse_filter::load(std::string const& filename) {
+  auto file = std::make_shared<mapped_file>(filename);
+  return load(file->data(), file->size(), file);
+}
+
+void binary_fuse_filter::add(object const&) {
+  throw std::logic_error("cannot add to an immutable binary fuse filter");
+}
+
+size_t binary_fuse_filter::lookup(object const& o) const {
+  if (size_ == 0)
+    return 0;
+  auto h = murmur64(hash_(o) + mix_);
+  size_t slots[3];
+  graph_.locate(h, slots);
+  auto f = fingerprint(h);
+  for (auto s : slots)
+    f ^= load_fingerprint(fingerprints_ + s * width_, width_);
+  auto mask = (uint64_t(1) << (width_ * 8)) - 1;
+  return (f & mask) == 0;
+}
+
+void binary_fuse_filter::clear() {
+  size_ = 0;
+  graph_ = {};
+  owner_.reset();
+  fingerprints_ = nullptr;
+}
+
+void binary_fuse_filter::save(std::ostream& out) const {
+  write_header(out, serialization_tag::binary_fuse_filter);
+  write<uint64_t>(out, seed_);
+  write<uint64_t>(out, width_);
+  write<uint64_t>(out, size_);
+  write<uint64_t>(out, mix_);
+  write<uint64_t>(out, graph_.segment_length());
+  write<uint64_t>(out, graph_.segment_count_length());
+  write<uint64_t>(out, graph_.slots());
+  out.write(reinterpret_cast<char const*>(fingerprints_),
+            graph_.slots() * width_);
+}
+
+size_t binary_fuse_filter::size() const {
+  return size_;
+}
+
+size_t binary_fuse_filter::slots() const {
+  return graph_.slots();
+}
+
+size_t binary_fuse_filter::fingerprint_bits() const {
+  return width_ * 8;
+}
+
+void binary_fuse_filter::build(std::vector<uint64_t> digests) {
+  std::sort(digests.begin(), digests.end());
+  digests.erase(std::unique(digests.begin(), digests.end()), digests.end());
+  size_ = digests.size();
+  graph_ = fuse_graph{size_};
+  auto array = std::make_shared<std::vector<unsigned char>>(graph_.slots()
+                                                            * width_);
+  std::vector<uint64_t> hashes(size_);
+  std::vector<fuse_graph::peeled> order;
+  std::minstd_rand0 prng(seed_);
+  for (size_t attempt = 0; attempt < max_attempts; ++attempt) {
+    mix_ = (static_cast<uint64_t>(prng()) << 32) | prng();
+    for (size_t i = 0; i < size_; ++i)
+      hashes[i] = murmur64(digests[i] + mix_);
+    if (!graph_.peel(hashes, order))
+      continue;
+    // Assign fingerprints in reverse peeling order, so that each key's free
+    // slot is written after all slots it depends on.
+    auto data = array->data();
+    size_t slots[3];
+    for (auto i = order.rbegin(); i != order.rend(); ++i) {
+      auto h = hashes[i->first];
+      graph_.locate(h, slots);
+      auto f = fingerprint(h);
+      for (uint8_t j = 0; j < 3; ++j)
+        if (j != i->second)
+          f ^= load_fingerprint(data + slots[j] * width_, width_);
+      store_fingerprint(data + slots[i->second] * width_, width_, f);
+    }
+    owner_ = array;
+    fingerprints_ = array->data();
+    return;
+  }
+  throw std::runtime_error("failed to construct binary fuse filter");
+}
+
+binary_fuse_filter binary_fuse_filter::load(void const* data, size_t size,
+                                            std::shared_ptr<void const> owner) {
+  reader source{data, size};
+  source.read_header(serialization_tag::binary_fuse_filter);
+  auto seed = source.read<uint64_t>();
+  auto width = source.read<uint64_t>();
+  binary_fuse_filter filter(width * 8, seed);
+  filter.size_ = source.read<uint64_t>();
+  filter.mix_ = source.read<uint64_t>();
+  auto segment_length = source.read<uint64_t>();
+  auto segment_count_length = source.read<uint64_t>();
+  auto slots = source.read<uint64_t>();
+  filter.graph_ = fuse_graph{segment_length, segment_count_length, slots};
+  filter.fingerprints_ = static_cast<unsigned char const*>(
+    source.skip(slots * width));
+  filter.owner_ = std::move(owner);
+  return filter;
+}
+
+} // namespace bf
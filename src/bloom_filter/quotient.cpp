@@ -0,0 +1,349 @@
+#include <bf/bloom_filter/quotient.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+
+namespace bf {
+
+namespace {
+
+// The low bits of each slot hold the metadata, the remaining bits the
+// remainder or, in a counter slot, one digit of the count.
+size_t const occupied = 1;      // The canonical slot has a run.
+size_t const continuation = 2;  // The slot continues the run of the previous.
+size_t const shifted = 4;       // The slot is not in its canonical position.
+size_t const counter = 8;       // The slot holds a digit of a count.
+size_t const flag_bits = 4;
+
+// The maximum fraction of canonical slots in use before the table doubles.
+double const max_load = 0.9;
+
+size_t table_size(size_t quotient_bits) {
+  // Runs near the end of the table spill into a few extra overflow slots.
+  auto canonical = size_t(1) << quotient_bits;
+  return canonical + canonical / 16 + 64;
+}
+
+size_t mask(size_t bits) {
+  return bits >= 64 ? ~size_t(0) : (size_t(1) << bits) - 1;
+}
+
+} // namespace <anonymous>
+
+counting_quotient_filter::counting_quotient_filter(hash_function h,
+                                                   size_t quotient_bits,
+                                                   size_t remainder_bits)
+    : hash_(std::move(h)),
+      q_(quotient_bits),
+      r_(remainder_bits),
+      slots_(table_size(quotient_bits), remainder_bits + flag_bits) {
+  assert(q_ > 0 && r_ > 0);
+  assert(q_ + r_ <= 64);
+  assert(r_ + flag_bits <= 64);
+}
+
+counting_quotient_filter::counting_quotient_filter(double fp, size_t capacity,
+                                                   size_t seed)
+    : counting_quotient_filter(
+        default_hash_function(seed),
+        std::max(1.0, std::ceil(std::log2(capacity / max_load))),
+        std::max(2.0, std::ceil(-std::log2(fp)))) {
+}
+
+void counting_quotient_filter::add(object const& o) {
+  add(o, 1);
+}
+
+void counting_quotient_filter::add(object const& o, size_t count) {
+  assert(count > 0);
+  if (used_ + 1 + digits(count) > max_load * (size_t(1) << q_))
+    resize();
+  auto x = locate(o);
+  auto insert = [&](std::vector<entry>& entries) {
+    auto i = std::lower_bound(
+      entries.begin(), entries.end(), x, [](entry const& a, entry const& b) {
+        return a.quotient < b.quotient
+               || (a.quotient == b.quotient && a.remainder < b.remainder);
+      });
+    if (i != entries.end() && i->quotient == x.quotient
+        && i->remainder == x.remainder)
+      i->count += count;
+    else
+      entries.insert(i, {x.quotient, x.remainder, count});
+  };
+  while (!update(x.quotient, insert)) {
+    resize();
+    x = locate(o);
+  }
+}
+
+size_t counting_quotient_filter::lookup(object const& o) const {
+  auto x = locate(o);
+  if (!(slots_.count(x.quotient) & occupied))
+    return 0;
+  // Walk back to the start of the cluster and then forward, skipping one run
+  // per occupied quotient, until reaching the run of x.
+  auto b = cluster_start(x.quotient);
+  auto s = b;
+  while (b != x.quotient) {
+    do
+      ++s;
+    while (slots_.count(s) & continuation);
+    do
+      ++b;
+    while (!(slots_.count(b) & occupied));
+  }
+  // Scan the sorted run.
+  do {
+    auto rem = slots_.count(s++) >> flag_bits;
+    size_t cnt = 1;
+    for (size_t digit = 0; s < slots_.size() && (slots_.count(s) & counter);
+         ++s, ++digit)
+      cnt += (slots_.count(s) >> flag_bits) << (r_ * digit);
+    if (rem == x.remainder)
+      return cnt;
+    if (rem > x.remainder)
+      return 0;
+  } while (s < slots_.size() && (slots_.count(s) & continuation));
+  return 0;
+}
+
+void counting_quotient_filter::clear() {
+  slots_.clear();
+  used_ = 0;
+}
+
+bool counting_quotient_filter::remove(object const& o, size_t count) {
+  auto x = locate(o);
+  if (!(slots_.count(x.quotient) & occupied))
+    return false;
+  auto found = false;
+  update(x.quotient, [&](std::vector<entry>& entries) {
+    for (auto i = entries.begin(); i != entries.end(); ++i)
+      if (i->quotient == x.quotient && i->remainder == x.remainder) {
+        found = true;
+        if (count >= i->count)
+          entries.erase(i);
+        else
+          i->count -= count;
+        return;
+      }
+  });
+  return found;
+}
+
+void counting_quotient_filter::merge(counting_quotient_filter const& other) {
+  assert(q_ + r_ == other.q_ + other.r_);
+  // Both tables decode in fingerprint order, so a single merge pass over the
+  // two sequences yields the sorted union.
+  auto fingerprints = [](std::vector<entry> entries, size_t r) {
+    for (auto& e : entries) {
+      e.remainder |= e.quotient << r;
+      e.quotient = 0;
+    }
+    return entries;
+  };
+  auto xs = fingerprints(decode(), r_);
+  auto ys = fingerprints(other.decode(), other.r_);
+  std::vector<entry> merged;
+  merged.reserve(xs.size() + ys.size());
+  auto x = xs.begin();
+  auto y = ys.begin();
+  while (x != xs.end() || y != ys.end())
+    if (y == ys.end() || (x != xs.end() && x->remainder < y->remainder)) {
+      merged.push_back(*x++);
+    } else if (x == xs.end() || y->remainder < x->remainder) {
+      merged.push_back(*y++);
+    } else {
+      merged.push_back(*x++);
+      merged.back().count += y++->count;
+    }
+  auto p = q_ + r_;
+  auto q = std::max(q_, other.q_);
+  size_t footprint = 0;
+  for (auto& e : merged)
+    footprint += 1 + digits(e.count);
+  while (footprint > max_load * (size_t(1) << q) && p - q > 1)
+    ++q;
+  r_ = p - q;
+  for (auto& e : merged) {
+    e.quotient = e.remainder >> r_;
+    e.remainder &= mask(r_);
+  }
+  rebuild(q, merged);
+}
+
+void counting_quotient_filter::resize() {
+  // With a single remainder bit left, the fingerprint cannot give up another
+  // bit to the quotient.
+  if (r_ <= 1)
+    throw std::length_error("quotient filter has no remainder bits to spare");
+  auto entries = decode();
+  --r_;
+  for (auto& e : entries) {
+    e.quotient = (e.quotient << 1) | (e.remainder >> r_);
+    e.remainder &= mask(r_);
+  }
+  rebuild(q_ + 1, entries);
+}
+
+size_t counting_quotient_filter::quotient_bits() const {
+  return q_;
+}
+
+size_t counting_quotient_filter::remainder_bits() const {
+  return r_;
+}
+
+size_t counting_quotient_filter::size() const {
+  return used_;
+}
+
+size_t counting_quotient_filter::slots() const {
+  return slots_.size();
+}
+
+size_t counting_quotient_filter::slot_bits() const {
+  return slots_.width();
+}
+
+size_t counting_quotient_filter::digits(size_t count) const {
+  size_t n = 0;
+  for (auto value = count - 1; value > 0; value >>= r_)
+    ++n;
+  return n;
+}
+
+counting_quotient_filter::entry
+counting_quotient_filter::locate(object const& o) const {
+  auto fingerprint = hash_(o) & mask(q_ + r_);
+  return {fingerprint >> r_, fingerprint & mask(r_), 1};
+}
+
+bool counting_quotient_filter::empty(size_t slot) const {
+  return (slots_.count(slot) & (occupied | continuation | shifted)) == 0;
+}
+
+size_t counting_quotient_filter::cluster_start(size_t slot) const {
+  while (slots_.count(slot) & shifted)
+    --slot;
+  return slot;
+}
+
+size_t counting_quotient_filter::decode(size_t start,
+                                        std::vector<entry>& entries) const {
+  // The first slot of a cluster holds the run of its canonical quotient.
+  // Each subsequent run belongs to the next occupied quotient.
+  auto q = start;
+  size_t digit = 0;
+  auto s = start;
+  for (; s < slots_.size() && !empty(s); ++s) {
+    auto slot = slots_.count(s);
+    if (s != start && !(slot & continuation))
+      do
+        ++q;
+      while (!(slots_.count(q) & occupied));
+    auto value = slot >> flag_bits;
+    if (slot & counter) {
+      entries.back().count += value << (r_ * digit++);
+    } else {
+      entries.push_back({q, value, 1});
+      digit = 0;
+    }
+  }
+  return s;
+}
+
+std::vector<counting_quotient_filter::entry>
+counting_quotient_filter::decode() const {
+  std::vector<entry> entries;
+  size_t s = 0;
+  while (s < slots_.size())
+    if (empty(s))
+      ++s;
+    else
+      s = decode(s, entries);
+  return entries;
+}
+
+size_t counting_quotient_filter::layout(size_t start,
+                                        std::vector<entry> const& entries)
+  const {
+  auto pos = start;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (i == 0 || entries[i].quotient != entries[i - 1].quotient)
+      pos = std::max(pos, entries[i].quotient);
+    pos += 1 + digits(entries[i].count);
+  }
+  return pos;
+}
+
+void counting_quotient_filter::encode(size_t start, size_t end,
+                                      std::vector<entry> const& entries) {
+  auto last = std::max(layout(start, entries), end);
+  for (auto s = start; s < last; ++s)
+    slots_.set(s, 0);
+  auto pos = start;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    auto& e = entries[i];
+    size_t flags = continuation | shifted;
+    if (i == 0 || e.quotient != entries[i - 1].quotient) {
+      pos = std::max(pos, e.quotient);
+      flags = pos == e.quotient ? 0 : shifted;
+    }
+    slots_.set(pos++, (e.remainder << flag_bits) | flags);
+    for (auto value = e.count - 1; value > 0; value >>= r_)
+      slots_.set(pos++, ((value & mask(r_)) << flag_bits) | continuation
+                          | shifted | counter);
+  }
+  for (auto& e : entries)
+    slots_.set(e.quotient, slots_.count(e.quotient) | occupied);
+}
+
+template <typename F>
+bool counting_quotient_filter::update(size_t quotient, F f) {
+  std::vector<entry> entries;
+  auto start = empty(quotient) ? quotient : cluster_start(quotient);
+  auto end = decode(start, entries);
+  auto footprint = [&] {
+    size_t n = 0;
+    for (auto& e : entries)
+      n += 1 + digits(e.count);
+    return n;
+  };
+  auto before = footprint();
+  f(entries);
+  auto after = footprint();
+  // If the modified region grows into the next cluster, absorb that cluster
+  // as well. The entries remain sorted because later clusters only hold
+  // larger quotients.
+  for (;;) {
+    auto required = layout(start, entries);
+    auto limit = end;
+    while (limit < slots_.size() && empty(limit))
+      ++limit;
+    if (required <= limit)
+      break;
+    if (limit == slots_.size())
+      return false;
+    end = decode(limit, entries);
+  }
+  encode(start, end, entries);
+  used_ = used_ + after - before;
+  return true;
+}
+
+void counting_quotient_filter::rebuild(size_t quotient_bits,
+                                       std::vector<entry> const& entries) {
+  q_ = quotient_bits;
+  auto size = std::max(table_size(q_), layout(0, entries));
+  slots_ = counter_vector(size, r_ + flag_bits);
+  used_ = 0;
+  for (auto& e : entries)
+    used_ += 1 + digits(e.count);
+  encode(0, 0, entries);
+}
+
+} // namespace bf
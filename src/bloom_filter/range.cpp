@@ -0,0 +1,131 @@
+#include <bf/bloom_filter/range.hpp>
+
+#include <algorithm>
+#include <cassert>
+
+namespace bf {
+
+namespace {
+
+// The number of ranges whose top-level probes are prefetched together.
+size_t const prefetch_group = 16;
+
+} // namespace <anonymous>
+
+range_bloom_filter::range_bloom_filter(double fp, size_t capacity,
+                                       uint64_t max_range, size_t seed) {
+  assert(fp > 0 && fp < 1);
+  assert(capacity > 0);
+  assert(max_range > 0);
+  size_t levels = 1;
+  while (levels < 64 && (uint64_t(1) << (levels - 1)) < max_range)
+    ++levels;
+  levels_.reserve(levels);
+  for (size_t l = 0; l < levels; ++l)
+    levels_.emplace_back(fp / 4, capacity, seed + l);
+}
+
+void range_bloom_filter::add(uint64_t key) {
+  for (size_t l = 0; l < levels_.size(); ++l)
+    levels_[l].add(key >> l);
+}
+
+size_t range_bloom_filter::lookup(uint64_t key) const {
+  return levels_[0].lookup(key);
+}
+
+size_t range_bloom_filter::lookup_range(uint64_t lo, uint64_t hi) const {
+  assert(lo <= hi);
+  for (auto x = lo;;) {
+    auto l = step(x, hi);
+    if (probe(l, x >> l))
+      return 1;
+    auto span = (uint64_t(1) << l) - 1;
+    if (hi - x <= span)
+      return 0;
+    x += span + 1;
+  }
+}
+
+std::vector<size_t>
+range_bloom_filter::lookup_range(std::vector<range> const& ranges) const {
+  // A range of at most the maximum length decomposes into at most two
+  // intervals per level. Longer ranges continue without prefetching.
+  auto max_intervals = 2 * levels_.size();
+  std::vector<size_t> result(ranges.size());
+  typedef std::pair<size_t, uint64_t> interval;
+  std::vector<std::vector<interval>> probes(prefetch_group);
+  std::vector<std::vector<std::vector<size_t>>> indices(prefetch_group);
+  std::vector<uint64_t> rest(prefetch_group);
+  for (size_t first = 0; first < ranges.size(); first += prefetch_group) {
+    auto last = std::min(first + prefetch_group, ranges.size());
+    for (auto i = first; i < last; ++i) {
+      auto lo = ranges[i].first;
+      auto hi = ranges[i].second;
+      assert(lo <= hi);
+      auto& ps = probes[i - first];
+      auto& idx = indices[i - first];
+      ps.clear();
+      idx.clear();
+      auto done = false;
+      for (auto x = lo; !done && ps.size() < max_intervals;) {
+        auto l = step(x, hi);
+        auto& level = levels_[l];
+        ps.emplace_back(l, x >> l);
+        idx.push_back(level.hasher_function()(wrap(x >> l)));
+        basic_bloom_filter::map_indices(idx.back(), level.storage().size(),
+                                        level.partitioned());
+        for (auto k : idx.back())
+          level.storage().prefetch(k);
+        auto span = (uint64_t(1) << l) - 1;
+        done = hi - x <= span;
+        x += span + 1;
+        rest[i - first] = done ? 0 : x;
+      }
+    }
+    for (auto i = first; i < last; ++i) {
+      auto& ps = probes[i - first];
+      auto& idx = indices[i - first];
+      for (size_t j = 0; j < ps.size() && !result[i]; ++j) {
+        auto& bits = levels_[ps[j].first].storage();
+        auto hit = std::all_of(idx[j].begin(), idx[j].end(),
+                               [&](size_t k) { return bits[k]; });
+        result[i] = hit && descend(ps[j].first, ps[j].second);
+      }
+      auto x = rest[i - first];
+      if (!result[i] && x != 0)
+        result[i] = lookup_range(x, ranges[i].second);
+    }
+  }
+  return result;
+}
+
+void range_bloom_filter::clear() {
+  for (auto& level : levels_)
+    level.clear();
+}
+
+size_t range_bloom_filter::levels() const {
+  return levels_.size();
+}
+
+size_t range_bloom_filter::step(uint64_t x, uint64_t hi) const {
+  // Grow the interval at x while it stays aligned and within the range.
+  auto top = levels_.size() - 1;
+  size_t l = 0;
+  while (l < top && (x & ((uint64_t(2) << l) - 1)) == 0
+         && hi - x >= (uint64_t(2) << l) - 1)
+    ++l;
+  return l;
+}
+
+bool range_bloom_filter::descend(size_t level, uint64_t prefix) const {
+  return level == 0 || probe(level - 1, 2 * prefix)
+         || probe(level - 1, 2 * prefix + 1);
+}
+
+bool range_bloom_filter::probe(size_t level, uint64_t prefix) const {
+  return levels_[level].lookup(prefix) && descend(level, prefix);
+}
+
+} // namespace bf
@@ -0,0 +1,184 @@
+#include <bf/bloom_filter/ribbon.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+namespace bf {
+
+namespace {
+
+uint64_t mulhi(uint64_t a, uint64_t b) {
+  return (static_cast<unsigned __int128>(a) * b) >> 64;
+}
+
+// Derives the first slot and the coefficients of a key's equation. The
+// lowest coefficient is always 1, so that the equation starts at its slot.
+void equation(uint64_t digest, size_t slots, size_t& start, uint64_t& row) {
+  start = mulhi(murmur64(digest ^ 0x9e3779b97f4a7c15ULL),
+                slots - ribbon_filter::band_width + 1);
+  row = murmur64(digest + 0x632be59bd9b4e019ULL) | 1;
+}
+
+} // namespace <anonymous>
+
+constexpr size_t ribbon_filter::band_width;
+constexpr size_t ribbon_filter::partition_size;
+constexpr double ribbon_filter::overhead;
+
+size_t ribbon_filter::fingerprint_bits(double fp) {
+  auto bits = std::ceil(-std::log2(fp));
+  return bits < 1 ? 1 : bits > 32 ? 32 : static_cast<size_t>(bits);
+}
+
+double ribbon_filter::bits_per_key(size_t fingerprint_bits) {
+  return fingerprint_bits * (1 + overhead);
+}
+
+ribbon_filter::ribbon_filter(size_t fingerprint_bits, size_t seed)
+    : r_(fingerprint_bits), seed_(seed), hash_(seed) {
+  assert(r_ > 0 && r_ <= 32);
+}
+
+void ribbon_filter::add(object const&) {
+  throw std::logic_error("cannot add to an immutable ribbon filter");
+}
+
+size_t ribbon_filter::lookup(object const& o) const {
+  if (size_ == 0)
+    return 0;
+  auto d = hash_(o);
+  auto& p = partitions_[which(d)];
+  size_t start;
+  uint64_t row;
+  equation(d, p.slots, start, row);
+  // The solution is stored in blocks of 64 slots, where each block holds one
+  // word per result bit. A band of 64 slots thus spans at most two blocks.
+  auto words = solution_.data() + p.offset + (start / band_width) * r_;
+  auto shift = start % band_width;
+  for (size_t j = 0; j < r_; ++j) {
+    auto band = words[j] >> shift;
+    if (shift > 0)
+      band |= words[r_ + j] << (band_width - shift);
+    if (__builtin_parityll(band & row))
+      return 0;
+  }
+  return 1;
+}
+
+void ribbon_filter::clear() {
+  size_ = 0;
+  partitions_.clear();
+  solution_.clear();
+}
+
+size_t ribbon_filter::size() const {
+  return size_;
+}
+
+size_t ribbon_filter::slots() const {
+  size_t n = 0;
+  for (auto& p : partitions_)
+    n += p.slots;
+  return n;
+}
+
+size_t ribbon_filter::partitions() const {
+  return partitions_.size();
+}
+
+size_t ribbon_filter::fingerprint_bits() const {
+  return r_;
+}
+
+void ribbon_filter::build(std::vector<uint64_t> const& digests,
+                          size_t threads) {
+  assert(threads > 0);
+  size_ = digests.size();
+  auto n = (size_ + partition_size - 1) / partition_size;
+  partitions_.resize(n > 0 ? n : 1);
+  // Counting sort of the digests by partition.
+  std::vector<size_t> bounds(partitions_.size() + 1);
+  for (auto d : digests)
+    ++bounds[which(d) + 1];
+  for (size_t i = 1; i < bounds.size(); ++i)
+    bounds[i] += bounds[i - 1];
+  std::vector<uint64_t> sorted(digests.size());
+  auto next = bounds;
+  for (auto d : digests)
+    sorted[next[which(d)]++] = d;
+  size_t words = 0;
+  for (size_t i = 0; i < partitions_.size(); ++i) {
+    auto keys = bounds[i + 1] - bounds[i];
+    auto& p = partitions_[i];
+    p.offset = words;
+    p.slots = std::ceil(keys * (1 + overhead)) + band_width - 1;
+    words += (p.slots + band_width - 1) / band_width * r_;
+  }
+  solution_.assign(words, 0);
+  // Partitions write to disjoint ranges of the solution.
+  auto work = [&](size_t t) {
+    for (auto i = t; i < partitions_.size(); i += threads)
+      solve(partitions_[i], sorted, bounds[i], bounds[i + 1], seed_ + i);
+  };
+  if (threads > partitions_.size())
+    threads = partitions_.size();
+  std::vector<std::thread> workers;
+  for (size_t t = 1; t < threads; ++t)
+    workers.emplace_back(work, t);
+  work(0);
+  for (auto& w : workers)
+    w.join();
+}
+
+void ribbon_filter::solve(partition const& p,
+                          std::vector<uint64_t> const& digests, size_t first,
+                          size_t last, uint64_t seed) {
+  // Banding: insert each equation into the row of its first non-zero
+  // coefficient, eliminating against existing rows on the way. An equation
+  // that reduces to zero is implied by the others and can be dropped.
+  std::vector<uint64_t> rows(p.slots);
+  for (auto i = first; i < last; ++i) {
+    size_t start;
+    uint64_t row;
+    equation(digests[i], p.slots, start, row);
+    for (;;) {
+      auto& existing = rows[start];
+      if (existing == 0) {
+        existing = row;
+        break;
+      }
+      row ^= existing;
+      if (row == 0)
+        break;
+      auto skip = __builtin_ctzll(row);
+      row >>= skip;
+      start += skip;
+    }
+  }
+  // Back-substitution from the last slot, with random values for free
+  // variables. For each result bit, a sliding window holds the solution of
+  // the 64 slots following the current one.
+  uint64_t windows[32] = {0};
+  auto words = solution_.data() + p.offset;
+  for (auto i = p.slots; i-- > 0;) {
+    auto row = rows[i];
+    auto free = row == 0 ? splitmix64(seed) : 0;
+    auto block = words + (i / band_width) * r_;
+    auto shift = i % band_width;
+    for (size_t j = 0; j < r_; ++j) {
+      windows[j] <<= 1;
+      uint64_t bit = row ? __builtin_parityll(row & windows[j])
+                         : (free >> j) & 1;
+      windows[j] |= bit;
+      block[j] |= bit << shift;
+    }
+  }
+}
+
+size_t ribbon_filter::which(uint64_t digest) const {
+  return mulhi(murmur64(digest), partitions_.size());
+}
+
+} // namespace bf
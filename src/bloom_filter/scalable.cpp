@@ -0,0 +1,107 @@
+#include <bf/bloom_filter/scalable.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace bf {
+
+namespace {
+
+// The number of elements whose bit positions a batch lookup prefetches before
+// probing any of them.
+size_t const prefetch_group = 16;
+
+} // namespace <anonymous>
+
+scalable_bloom_filter::scalable_bloom_filter(double fp, size_t capacity,
+                                             size_t growth, double tightening,
+                                             size_t seed)
+    : fp_(fp),
+      capacity_(capacity),
+      growth_(growth),
+      tightening_(tightening),
+      seed_(seed) {
+  assert(fp > 0 && fp < 1);
+  assert(capacity > 0);
+  assert(growth > 0);
+  assert(tightening > 0 && tightening < 1);
+  grow();
+}
+
+void scalable_bloom_filter::add(object const& o) {
+  if (lookup(o))
+    return;
+  if (items_ >= capacities_.back())
+    grow();
+  slices_.back().add(o);
+  ++items_;
+  ++size_;
+}
+
+size_t scalable_bloom_filter::lookup(object const& o) const {
+  for (auto s = slices_.rbegin(); s != slices_.rend(); ++s)
+    if (s->lookup(o))
+      return 1;
+  return 0;
+}
+
+std::vector<size_t>
+scalable_bloom_filter::lookup(std::vector<object> const& os) const {
+  std::vector<size_t> result(os.size());
+  // The bit positions of a group of elements in all slices, and where those
+  // of each element and slice begin. Both buffers are reused for all groups.
+  std::vector<size_t> positions;
+  std::vector<size_t> offsets;
+  for (size_t first = 0; first < os.size(); first += prefetch_group) {
+    auto last = std::min(first + prefetch_group, os.size());
+    positions.clear();
+    offsets.clear();
+    for (auto i = first; i < last; ++i)
+      for (auto& slice : slices_) {
+        offsets.push_back(positions.size());
+        auto digests = slice.hasher_function()(os[i]);
+        basic_bloom_filter::map_indices(digests, slice.storage().size(),
+                                        slice.partitioned());
+        for (auto j : digests)
+          slice.storage().prefetch(j);
+        positions.insert(positions.end(), digests.begin(), digests.end());
+      }
+    offsets.push_back(positions.size());
+    for (auto i = first; i < last; ++i)
+      for (auto s = slices_.size(); s-- > 0 && !result[i];) {
+        auto k = (i - first) * slices_.size() + s;
+        auto& bits = slices_[s].storage();
+        result[i] = std::all_of(positions.begin() + offsets[k],
+                                positions.begin() + offsets[k + 1],
+                                [&](size_t j) { return bits[j]; });
+      }
+  }
+  return result;
+}
+
+void scalable_bloom_filter::clear() {
+  slices_.clear();
+  capacities_.clear();
+  size_ = 0;
+  grow();
+}
+
+size_t scalable_bloom_filter::slices() const {
+  return slices_.size();
+}
+
+size_t scalable_bloom_filter::size() const {
+  return size_;
+}
+
+void scalable_bloom_filter::grow() {
+  auto i = slices_.size();
+  auto fp = fp_ * (1 - tightening_) * std::pow(tightening_, i);
+  auto capacity = static_cast<size_t>(capacity_ * std::pow(growth_, i));
+  slices_.emplace_back(fp, capacity, seed_ + i, true, true);
+  capacities_.push_back(capacity);
+  items_ = 0;
+}
+
+} // namespace bf
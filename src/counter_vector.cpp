@@ -1,31 +1,91 @@
 #include <bf/counter_vector.hpp>
 
+#include <algorithm>
 #include <cassert>
 
 namespace bf {
 
+namespace {
+
+typedef bitvector::block_type block_type;
+
+// Masks for cells of a width that divides the block size.
+struct swar_layout
+{
+  explicit swar_layout(size_t width) : width(width)
+  {
+    for (size_t i = 0; i < bitvector::bits_per_block; i += width)
+      lsb |= block_type(1) << i;
+    msb = lsb << (width - 1);
+    ones = ~block_type(0) >> (bitvector::bits_per_block - width);
+  }
+
+  // Adds the cells of two blocks, saturating at the maximum. The low bits
+  // of two cells cannot carry out of the cell, and the carry out of the
+  // most significant bit sets the whole cell.
+  block_type saturating_add(block_type x, block_type y) const
+  {
+    auto sum = ((x & ~msb) + (y & ~msb)) ^ ((x ^ y) & msb);
+    auto carry = ((x & y) | ((x | y) & ~sum)) & msb;
+    return sum | (carry >> (width - 1)) * ones;
+  }
+
+  // Selects the smaller cell of two blocks. The most significant bit of a
+  // cell of t is set iff the low bits of x are at least those of y, which
+  // decides the comparison unless the most significant bits differ.
+  block_type min(block_type x, block_type y) const
+  {
+    auto t = (x | msb) - (y & ~msb);
+    auto ge = ((x & ~y) | (~(x ^ y) & t)) & msb;
+    auto mask = (ge >> (width - 1)) * ones;
+    return (y & mask) | (x & ~mask);
+  }
+
+  // Sets the most significant bit of each nonzero cell. The low bits of a
+  // cell plus all-ones in the low bits carry into the most significant bit
+  // iff they are nonzero, without carrying across cells.
+  block_type nonzero(block_type x) const
+  {
+    return (((x & ~msb) + ~msb) | x) & msb;
+  }
+
+  size_t width;
+  block_type lsb = 0;
+  block_type msb = 0;
+  block_type ones = 0; // A single cell with all bits set.
+};
+
+// Invokes a function with each block overlapping a bit range and a mask of
+// the bits of the block inside the range.
+template <typename Blocks, typename F>
+void for_each_block(Blocks& blocks, size_t begin, size_t end, F f) {
+  auto const bits = bitvector::bits_per_block;
+  while (begin < end) {
+    auto offset = begin % bits;
+    auto n = std::min(end - begin, bits - offset);
+    auto range = n == bits ? ~block_type(0)
+                           : ((block_type(1) << n) - 1) << offset;
+    f(blocks[begin / bits], range);
+    begin += n;
+  }
+}
+
+} // namespace <anonymous>
+
 counter_vector::counter_vector(size_t cells, size_t width)
     : bits_(cells * width), width_(width) {
   assert(cells > 0);
   assert(width > 0);
 }
 
+counter_vector::counter_vector(bitvector bits, size_t width)
+    : bits_(std::move(bits)), width_(width) {
+  assert(width > 0);
+  assert(bits_.size() > 0 && bits_.size() % width == 0);
+}
+
 counter_vector& counter_vector::operator|=(counter_vector const& other) {
-  assert(size() == other.size());
-  assert(width() == other.width());
-  for (size_t cell = 0; cell < size(); ++cell) {
-    bool carry = false;
-    size_t lsb = cell * width_;
-    for (size_t i = 0; i < width_; ++i) {
-      bool b1 = bits_[lsb + i];
-      bool b2 = other.bits_[lsb + i];
-      bits_[lsb + i] = b1 ^ b2 ^ carry;
-      carry = (b1 && b2) || (carry && (b1 != b2));
-    }
-    if (carry)
-      for (size_t i = 0; i < width_; ++i)
-        bits_.set(lsb + i);
-  }
+  add_range(other, 0, size());
   return *this;
 }
 
@@ -37,52 +97,143 @@ counter_vector operator|(counter_vector const& x, counter_vector const& y) {
 bool counter_vector::increment(size_t cell, size_t value) {
   assert(cell < size());
   assert(value != 0);
-  size_t lsb = cell * width_;
-  bool carry = false;
-  for (size_t i = 0; i < width_; ++i) {
-    bool b1 = bits_[lsb + i];
-    bool b2 = value & (1 << i);
-    bits_[lsb + i] = b1 ^ b2 ^ carry;
-    carry = (b1 && b2) || (carry && (b1 != b2));
+  auto cnt = count(cell);
+  if (value > max() - cnt) {
+    set(cell, max());
+    return false;
   }
-  if (carry)
-    for (size_t i = 0; i < width_; ++i)
-      bits_[lsb + i] = true;
-  return !carry;
+  set(cell, cnt + value);
+  return true;
 }
 
 bool counter_vector::decrement(size_t cell, size_t value) {
   assert(cell < size());
   assert(value != 0);
-  value = ~value + 1; // A - B := A + ~B + 1
-  bool carry = false;
-  size_t lsb = cell * width_;
-  for (size_t i = 0; i < width_; ++i) {
-    bool b1 = bits_[lsb + i];
-    bool b2 = value & (1 << i);
-    bits_[lsb + i] = b1 ^ b2 ^ carry;
-    carry = (b1 && b2) || (carry && (b1 != b2));
+  auto cnt = count(cell);
+  if (value > cnt) {
+    set(cell, 0);
+    return false;
   }
-  return carry;
+  set(cell, cnt - value);
+  return true;
+}
+
+void counter_vector::add_range(counter_vector const& other, size_t first,
+                               size_t last) {
+  assert(size() == other.size());
+  assert(width() == other.width());
+  assert(first <= last && last <= size());
+  if (bitvector::bits_per_block % width_ != 0) {
+    for (auto i = first; i < last; ++i) {
+      auto y = other.count(i);
+      if (y > 0)
+        set(i, std::min(count(i), max() - y) + y);
+    }
+    return;
+  }
+  swar_layout swar{width_};
+  auto blocks = bits_.bits_.data();
+  auto others = other.bits_.bits_.data();
+  for_each_block(bits_.bits_, first * width_, last * width_,
+                 [&](block_type& x, block_type range) {
+                   auto y = others[&x - blocks] & range;
+                   x = swar.saturating_add(x, y);
+                 });
+}
+
+void counter_vector::min_range(counter_vector const& other, size_t first,
+                               size_t last) {
+  assert(size() == other.size());
+  assert(width() == other.width());
+  assert(first <= last && last <= size());
+  if (bitvector::bits_per_block % width_ != 0) {
+    for (auto i = first; i < last; ++i) {
+      auto y = other.count(i);
+      if (y < count(i))
+        set(i, y);
+    }
+    return;
+  }
+  swar_layout swar{width_};
+  auto blocks = bits_.bits_.data();
+  auto others = other.bits_.bits_.data();
+  for_each_block(bits_.bits_, first * width_, last * width_,
+                 [&](block_type& x, block_type range) {
+                   auto y = others[&x - blocks];
+                   x = (swar.min(x, y) & range) | (x & ~range);
+                 });
+}
+
+void counter_vector::decrement_range(size_t first, size_t last) {
+  assert(first <= last && last <= size());
+  if (bitvector::bits_per_block % width_ != 0) {
+    for (auto i = first; i < last; ++i) {
+      auto cnt = count(i);
+      if (cnt > 0)
+        set(i, cnt - 1);
+    }
+    return;
+  }
+  swar_layout swar{width_};
+  for_each_block(bits_.bits_, first * width_, last * width_,
+                 [&](block_type& x, block_type range) {
+                   auto nonzero = swar.nonzero(x) & range;
+                   x -= nonzero >> (width_ - 1);
+                 });
+}
+
+size_t counter_vector::count_equal(size_t first, size_t last,
+                                   size_t value) const {
+  assert(first <= last && last <= size());
+  assert(value <= max());
+  size_t n = 0;
+  if (bitvector::bits_per_block % width_ != 0) {
+    for (auto i = first; i < last; ++i)
+      n += count(i) == value;
+    return n;
+  }
+  swar_layout swar{width_};
+  auto pattern = swar.lsb * value;
+  for_each_block(bits_.bits_, first * width_, last * width_,
+                 [&](block_type const& x, block_type range) {
+                   auto differ = swar.nonzero(x ^ pattern);
+                   n += __builtin_popcountll(~differ & swar.msb & range);
+                 });
+  return n;
 }
 
 size_t counter_vector::count(size_t cell) const {
   assert(cell < size());
-  size_t cnt = 0, order = 1;
-  size_t lsb = cell * width_;
-  for (auto i = lsb; i < lsb + width_; ++i, order <<= 1)
-    if (bits_[i])
-      cnt |= order;
-  return cnt;
+  auto lsb = cell * width_;
+  auto block = lsb / bitvector::bits_per_block;
+  auto offset = lsb % bitvector::bits_per_block;
+  auto& blocks = bits_.bits_;
+  size_t cnt = blocks[block] >> offset;
+  // A cell may straddle two blocks.
+  if (offset + width_ > bitvector::bits_per_block)
+    cnt |= blocks[block + 1] << (bitvector::bits_per_block - offset);
+  return cnt & max();
 }
 
 void counter_vector::set(size_t cell, size_t value) {
   assert(cell < size());
   assert(value <= max());
-  bitvector bits(width_, value);
+  auto mask = max();
   auto lsb = cell * width_;
-  for (size_t i = 0; i < width_; ++i)
-    bits_[lsb + i] = bits[i];
+  auto block = lsb / bitvector::bits_per_block;
+  auto offset = lsb % bitvector::bits_per_block;
+  auto& blocks = bits_.bits_;
+  blocks[block] = (blocks[block] & ~(mask << offset)) | (value << offset);
+  if (offset + width_ > bitvector::bits_per_block) {
+    auto shift = bitvector::bits_per_block - offset;
+    blocks[block + 1] =
+      (blocks[block + 1] & ~(mask >> shift)) | (value >> shift);
+  }
+}
+
+void counter_vector::prefetch(size_t cell) const {
+  assert(cell < size());
+  bits_.prefetch(cell * width_);
 }
 
 void counter_vector::clear() {
@@ -102,4 +253,8 @@ size_t counter_vector::width() const {
   return width_;
 }
 
+bitvector const& counter_vector::bits() const {
+  return bits_;
+}
+
 } // namespace bf
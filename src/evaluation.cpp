@@ -0,0 +1,208 @@
+#include <bf/evaluation.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <unordered_set>
+#include <utility>
+#include <bf/hash.hpp>
+
+namespace bf {
+
+namespace {
+
+typedef std::pair<size_t, size_t> span; // Offset and length.
+
+void append(std::vector<char>& bytes, std::vector<span>& spans,
+            void const* data, size_t size) {
+  auto p = static_cast<char const*>(data);
+  spans.emplace_back(bytes.size(), size);
+  bytes.insert(bytes.end(), p, p + size);
+}
+
+void append(std::vector<char>& bytes, std::vector<span>& spans, uint64_t x) {
+  append(bytes, spans, &x, sizeof(x));
+}
+
+// Samples ranks in [0, n) with probability proportional to 1 / (rank + 1)^s
+// by inverting the cumulative distribution.
+class zipf_distribution {
+public:
+  zipf_distribution(size_t n, double s) : cdf_(n) {
+    double sum = 0;
+    for (size_t i = 0; i < n; ++i)
+      cdf_[i] = sum += 1 / std::pow(i + 1, s);
+    for (auto& x : cdf_)
+      x /= sum;
+  }
+
+  template <typename Generator>
+  size_t operator()(Generator& g) {
+    auto u = std::uniform_real_distribution<double>{}(g);
+    auto i = std::lower_bound(cdf_.begin(), cdf_.end(), u) - cdf_.begin();
+    return std::min<size_t>(i, cdf_.size() - 1);
+  }
+
+private:
+  std::vector<double> cdf_;
+};
+
+typedef std::chrono::steady_clock clock_type;
+
+double seconds_since(clock_type::time_point start) {
+  std::chrono::duration<double> d = clock_type::now() - start;
+  return std::max(d.count(), 1e-9);
+}
+
+} // namespace <anonymous>
+
+workload::distribution_type parse_distribution(std::string const& name) {
+  if (name == "uniform")
+    return workload::uniform;
+  if (name == "zipf")
+    return workload::zipf;
+  if (name == "sequential")
+    return workload::sequential;
+  if (name == "strings")
+    return workload::strings;
+  throw std::invalid_argument("unknown key distribution: " + name);
+}
+
+dataset::dataset(workload const& w) {
+  assert(w.min_length > 0 && w.min_length <= w.max_length);
+  std::mt19937_64 prng(w.seed);
+  std::vector<span> keys, queries;
+  switch (w.distribution) {
+    case workload::uniform:
+      for (size_t i = 0; i < w.keys; ++i)
+        append(bytes_, keys, prng());
+      for (size_t i = 0; i < w.queries; ++i)
+        append(bytes_, queries, prng());
+      break;
+    case workload::zipf: {
+      // Insert a random subset of the universe, so that popularity and
+      // membership are independent.
+      auto universe = w.keys + w.queries;
+      std::vector<uint64_t> ranks(universe);
+      for (size_t i = 0; i < universe; ++i)
+        ranks[i] = i;
+      for (size_t i = 0; i < w.keys; ++i) {
+        auto j = i + prng() % (universe - i);
+        std::swap(ranks[i], ranks[j]);
+        append(bytes_, keys, murmur64(ranks[i] + w.seed));
+      }
+      zipf_distribution rank(universe, w.skew);
+      for (size_t i = 0; i < w.queries; ++i)
+        append(bytes_, queries, murmur64(rank(prng) + w.seed));
+      break;
+    }
+    case workload::sequential:
+      for (uint64_t i = 0; i < w.keys; ++i)
+        append(bytes_, keys, i);
+      for (uint64_t i = 0; i < w.queries; ++i)
+        append(bytes_, queries, w.keys + i);
+      break;
+    case workload::strings: {
+      static char const alphabet[] =
+        "0123456789abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ";
+      std::uniform_int_distribution<size_t> length(w.min_length,
+                                                   w.max_length);
+      std::uniform_int_distribution<size_t> letter(0, sizeof(alphabet) - 2);
+      std::string s;
+      for (size_t i = 0; i < w.keys + w.queries; ++i) {
+        s.resize(length(prng));
+        for (auto& c : s)
+          c = alphabet[letter(prng)];
+        append(bytes_, i < w.keys ? keys : queries, s.data(), s.size());
+      }
+      break;
+    }
+  }
+  // Deduplicate the keys and record the ground truth of each query.
+  std::unordered_set<std::string> truth;
+  auto data = bytes_.data();
+  for (auto& k : keys)
+    if (truth.emplace(data + k.first, k.second).second)
+      keys_.emplace_back(data + k.first, k.second);
+  for (auto& q : queries) {
+    queries_.emplace_back(data + q.first, q.second);
+    members_.push_back(truth.count(std::string(data + q.first, q.second)));
+  }
+}
+
+std::vector<object> const& dataset::keys() const {
+  return keys_;
+}
+
+std::vector<object> const& dataset::queries() const {
+  return queries_;
+}
+
+bool dataset::member(size_t i) const {
+  assert(i < members_.size());
+  return members_[i];
+}
+
+evaluation evaluate(candidate const& c, dataset const& data) {
+  auto& keys = data.keys();
+  auto& queries = data.queries();
+  evaluation e;
+  e.name = c.name;
+  e.keys = keys.size();
+  e.queries = queries.size();
+  auto start = clock_type::now();
+  auto filter = c.build(keys);
+  e.build_rate = keys.size() / seconds_since(start);
+  std::vector<size_t> results(queries.size());
+  start = clock_type::now();
+  for (size_t i = 0; i < queries.size(); ++i)
+    results[i] = filter->lookup(queries[i]);
+  e.query_rate = queries.size() / seconds_since(start);
+  for (size_t i = 0; i < queries.size(); ++i) {
+    if (data.member(i)) {
+      e.false_negatives += results[i] == 0;
+    } else {
+      ++e.negatives;
+      e.false_positives += results[i] != 0;
+    }
+  }
+  if (!keys.empty())
+    e.bits_per_key = static_cast<double>(c.bits(*filter)) / keys.size();
+  return e;
+}
+
+void write_csv(std::ostream& out, std::vector<evaluation> const& results) {
+  out << "filter,keys,queries,negatives,false_positives,false_negatives,"
+         "fp_rate,bits_per_key,build_keys_per_s,queries_per_s\n";
+  for (auto& e : results)
+    out << e.name << ',' << e.keys << ',' << e.queries << ',' << e.negatives
+        << ',' << e.false_positives << ',' << e.false_negatives << ','
+        << e.fp_rate() << ',' << e.bits_per_key << ',' << e.build_rate << ','
+        << e.query_rate << '\n';
+}
+
+void write_json(std::ostream& out, std::vector<evaluation> const& results) {
+  out << '[';
+  for (size_t i = 0; i < results.size(); ++i) {
+    auto& e = results[i];
+    out << (i == 0 ? "\n" : ",\n") << "  {\"filter\": \"";
+    for (auto c : e.name)
+      if (c == '"' || c == '\\')
+        out << '\\' << c;
+      else
+        out << c;
+    out << "\", \"keys\": " << e.keys << ", \"queries\": " << e.queries
+        << ", \"negatives\": " << e.negatives << ", \"false_positives\": "
+        << e.false_positives << ", \"false_negatives\": " << e.false_negatives
+        << ", \"fp_rate\": " << e.fp_rate() << ", \"bits_per_key\": "
+        << e.bits_per_key << ", \"build_keys_per_s\": " << e.build_rate
+        << ", \"queries_per_s\": " << e.query_rate << '}';
+  }
+  out << "\n]\n";
+}
+
+} // namespace bf
@@ -0,0 +1,91 @@
+#include <bf/fuse_graph.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace bf {
+
+fuse_graph::fuse_graph(size_t n) {
+  // Parameters from Graf and Lemire for arity 3.
+  static uint64_t const max_segment_length = 1 << 18;
+  auto log_n = std::log(static_cast<double>(std::max<size_t>(n, 2)));
+  auto exponent = static_cast<int>(log_n / std::log(3.33) + 2.25);
+  segment_length_ = n == 0 ? 4 : uint64_t(1) << exponent;
+  segment_length_ = std::min(segment_length_, max_segment_length);
+  auto size_factor =
+    std::max(1.125, 0.875 + 0.25 * std::log(1000000.0) / log_n);
+  uint64_t capacity = n <= 1 ? 0 : std::round(n * size_factor);
+  auto segments = (capacity + segment_length_ - 1) / segment_length_;
+  auto segment_count = segments > 2 ? segments - 2 : 1;
+  slots_ = (segment_count + 2) * segment_length_;
+  segment_count_length_ = segment_count * segment_length_;
+}
+
+fuse_graph::fuse_graph(uint64_t segment_length, uint64_t segment_count_length,
+                       uint64_t slots)
+    : segment_length_(segment_length),
+      segment_count_length_(segment_count_length),
+      slots_(slots) {
+  if (segment_length_ == 0 || (segment_length_ & (segment_length_ - 1)) != 0
+      || slots_ < segment_count_length_ + 2 * segment_length_)
+    throw std::runtime_error("invalid fuse graph layout");
+}
+
+bool fuse_graph::peel(std::vector<uint64_t> const& hashes,
+                      std::vector<peeled>& order) const {
+  // For every slot, track the number of incident keys, the XOR of their
+  // positions in the input, and the XOR of the slot's index (0, 1, or 2)
+  // among each key's three slots. A slot with a single key identifies that
+  // key directly.
+  std::vector<uint32_t> counts(slots_);
+  std::vector<size_t> xors(slots_);
+  std::vector<uint8_t> positions(slots_);
+  std::vector<size_t> queue;
+  order.clear();
+  size_t slots[3];
+  for (size_t k = 0; k < hashes.size(); ++k) {
+    locate(hashes[k], slots);
+    for (uint8_t i = 0; i < 3; ++i) {
+      ++counts[slots[i]];
+      xors[slots[i]] ^= k;
+      positions[slots[i]] ^= i;
+    }
+  }
+  for (size_t i = 0; i < slots_; ++i)
+    if (counts[i] == 1)
+      queue.push_back(i);
+  // Repeatedly remove a key that is the only one in one of its slots.
+  while (!queue.empty()) {
+    auto i = queue.back();
+    queue.pop_back();
+    if (counts[i] != 1)
+      continue;
+    auto k = xors[i];
+    order.emplace_back(k, positions[i]);
+    locate(hashes[k], slots);
+    for (uint8_t j = 0; j < 3; ++j) {
+      auto s = slots[j];
+      --counts[s];
+      xors[s] ^= k;
+      positions[s] ^= j;
+      if (counts[s] == 1)
+        queue.push_back(s);
+    }
+  }
+  return order.size() == hashes.size();
+}
+
+uint64_t fuse_graph::segment_length() const {
+  return segment_length_;
+}
+
+uint64_t fuse_graph::segment_count_length() const {
+  return segment_count_length_;
+}
+
+uint64_t fuse_graph::slots() const {
+  return slots_;
+}
+
+} // namespace bf
@@ -17,8 +17,9 @@ size_t default_hash_function::operator()(object const& o) const {
   return o.size() == 0 ? 0 : h3_(o.data(), o.size());
 }
 
-default_hasher::default_hasher(std::vector<hash_function> fns)
-    : fns_(std::move(fns)) {
+default_hasher::default_hasher(std::vector<hash_function> fns,
+                               hasher_descriptor d)
+    : fns_(std::move(fns)), descriptor_(d) {
 }
 
 std::vector<digest> default_hasher::operator()(object const& o) const {
@@ -28,8 +29,13 @@ std::vector<digest> default_hasher::operator()(object const& o) const {
   return d;
 }
 
-double_hasher::double_hasher(size_t k, hash_function h1, hash_function h2)
-    : k_(k), h1_(std::move(h1)), h2_(std::move(h2)) {
+hasher_descriptor const& default_hasher::descriptor() const {
+  return descriptor_;
+}
+
+double_hasher::double_hasher(size_t k, hash_function h1, hash_function h2,
+                             hasher_descriptor d)
+    : k_(k), h1_(std::move(h1)), h2_(std::move(h2)), descriptor_(d) {
 }
 
 std::vector<digest> double_hasher::operator()(object const& o) const {
@@ -41,19 +47,56 @@ std::vector<digest> double_hasher::operator()(object const& o) const {
   return d;
 }
 
+hasher_descriptor const& double_hasher::descriptor() const {
+  return descriptor_;
+}
+
 hasher make_hasher(size_t k, size_t seed, bool double_hashing) {
   assert(k > 0);
-  std::minstd_rand0 prng(seed);
-  if (double_hashing) {
+  hasher_descriptor d;
+  d.family = hasher_descriptor::h3;
+  d.k = k;
+  d.seed = seed;
+  d.double_hashing = double_hashing;
+  return make_hasher(d);
+}
+
+hasher make_hasher(hasher_descriptor const& d) {
+  if (d.family != hasher_descriptor::h3)
+    throw std::invalid_argument("cannot rebuild a custom hasher");
+  if (d.k == 0)
+    throw std::invalid_argument("hasher without hash functions");
+  // The mapping is a property of the filter, not of the hasher.
+  auto desc = d;
+  desc.mapping = hasher_descriptor::modulo;
+  std::minstd_rand0 prng(d.seed);
+  if (d.double_hashing) {
     auto h1 = default_hash_function(prng());
     auto h2 = default_hash_function(prng());
-    return double_hasher(k, std::move(h1), std::move(h2));
+    return double_hasher(d.k, std::move(h1), std::move(h2), desc);
   } else {
-    std::vector<hash_function> fns(k);
-    for (size_t i = 0; i < k; ++i)
+    std::vector<hash_function> fns(d.k);
+    for (size_t i = 0; i < d.k; ++i)
       fns[i] = default_hash_function(prng());
-    return default_hasher(std::move(fns));
+    return default_hasher(std::move(fns), desc);
   }
 }
 
+hasher_descriptor describe(hasher const& h) {
+  if (auto p = h.target<default_hasher>())
+    return p->descriptor();
+  if (auto p = h.target<double_hasher>())
+    return p->descriptor();
+  return {};
+}
+
+uint64_t fingerprint(hasher const& h) {
+  static char const probe[] = "libbf hasher fingerprint";
+  auto digests = h(object{probe, sizeof(probe) - 1});
+  auto x = murmur64(digests.size());
+  for (auto d : digests)
+    x = murmur64(x ^ d);
+  return x;
+}
+
 } // namespace bf
@@ -0,0 +1,151 @@
+#include <bf/iblt.hpp>
+
+#include <cassert>
+#include <cmath>
+#include <stdexcept>
+#include <bf/serialization.hpp>
+#include <bf/wrap.hpp>
+
+namespace bf {
+
+size_t iblt::cells(size_t entries, size_t k) {
+  assert(k > 0);
+  // Peeling succeeds with high probability above 1.222 cells per entry for
+  // k = 3; small tables need additional slack.
+  auto m = static_cast<size_t>(std::ceil(entries * 1.5)) + 10 * k;
+  return (m + k - 1) / k * k;
+}
+
+iblt::iblt(size_t cells, size_t k, size_t seed)
+    : k_(k),
+      seed_(seed),
+      hasher_(make_hasher(k, seed)),
+      cells_(cells, cell{0, 0, 0}) {
+  assert(k > 0);
+  assert(cells >= k);
+}
+
+void iblt::insert(uint64_t key) {
+  update(key, 1);
+}
+
+void iblt::erase(uint64_t key) {
+  update(key, -1);
+}
+
+void iblt::subtract(iblt const& other) {
+  if (k_ != other.k_ || seed_ != other.seed_
+      || cells_.size() != other.cells_.size())
+    throw std::invalid_argument("incompatible IBLT parameters");
+  for (size_t i = 0; i < cells_.size(); ++i) {
+    cells_[i].count -= other.cells_[i].count;
+    cells_[i].key_sum ^= other.cells_[i].key_sum;
+    cells_[i].hash_sum ^= other.cells_[i].hash_sum;
+  }
+}
+
+bool iblt::list_entries(std::vector<uint64_t>& inserted,
+                        std::vector<uint64_t>& erased) const {
+  auto table = *this;
+  std::vector<size_t> queue;
+  for (size_t i = 0; i < table.cells_.size(); ++i)
+    if (table.pure(table.cells_[i]))
+      queue.push_back(i);
+  while (!queue.empty()) {
+    auto& c = table.cells_[queue.back()];
+    queue.pop_back();
+    // A cell may have changed since it was queued.
+    if (!table.pure(c))
+      continue;
+    auto key = c.key_sum;
+    auto count = c.count;
+    (count > 0 ? inserted : erased).push_back(key);
+    for (auto i : table.find_indices(key)) {
+      table.cells_[i].count -= count;
+      table.cells_[i].key_sum ^= key;
+      table.cells_[i].hash_sum ^= checksum(key);
+      if (table.pure(table.cells_[i]))
+        queue.push_back(i);
+    }
+  }
+  for (auto& c : table.cells_)
+    if (c.count != 0 || c.key_sum != 0 || c.hash_sum != 0)
+      return false;
+  return true;
+}
+
+void iblt::clear() {
+  for (auto& c : cells_)
+    c = cell{0, 0, 0};
+}
+
+void iblt::save(std::ostream& out) const {
+  write_header(out, serialization_tag::iblt);
+  write<uint64_t>(out, k_);
+  write<uint64_t>(out, seed_);
+  write<uint64_t>(out, cells_.size());
+  for (auto& c : cells_) {
+    write<int64_t>(out, c.count);
+    write<uint64_t>(out, c.key_sum);
+    write<uint64_t>(out, c.hash_sum);
+  }
+}
+
+iblt iblt::load(std::istream& in) {
+  auto buffer = slurp(in);
+  reader source{buffer->data(), buffer->size()};
+  source.read_header(serialization_tag::iblt);
+  auto k = source.read<uint64_t>();
+  auto seed = source.read<uint64_t>();
+  auto size = source.read<uint64_t>();
+  if (k == 0 || size < k || size > source.remaining() / 24)
+    throw std::runtime_error("corrupt IBLT");
+  iblt table(size, k, seed);
+  for (auto& c : table.cells_) {
+    c.count = source.read<int64_t>();
+    c.key_sum = source.read<uint64_t>();
+    c.hash_sum = source.read<uint64_t>();
+  }
+  return table;
+}
+
+size_t iblt::size() const {
+  return cells_.size();
+}
+
+size_t iblt::k() const {
+  return k_;
+}
+
+void iblt::update(uint64_t key, int64_t delta) {
+  auto hash = checksum(key);
+  for (auto i : find_indices(key)) {
+    cells_[i].count += delta;
+    cells_[i].key_sum ^= key;
+    cells_[i].hash_sum ^= hash;
+  }
+}
+
+std::vector<size_t> iblt::find_indices(uint64_t key) const {
+  // Partitioning guarantees k distinct cells, without which a key would
+  // cancel itself out of a cell.
+  auto indices = hasher_(wrap(key));
+  auto parts = cells_.size() / k_;
+  for (size_t i = 0; i < indices.size(); ++i)
+    indices[i] = i * parts + indices[i] % parts;
+  return indices;
+}
+
+uint64_t iblt::checksum(uint64_t key) const {
+  // The checksum must not be linear over XOR like H3: otherwise the XOR of
+  // the checksums of an odd number of keys would equal the checksum of the
+  // XOR of the keys, and every cell with a count of 1 would appear pure.
+  return murmur64(key ^ (seed_ * 0x9e3779b97f4a7c15ULL));
+}
+
+bool iblt::pure(cell const& c) const {
+  return (c.count == 1 || c.count == -1)
+         && c.hash_sum == checksum(c.key_sum);
+}
+
+} // namespace bf
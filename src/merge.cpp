@@ -0,0 +1,142 @@
+#include <bf/merge.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <bf/bulk.hpp>
+#include <bf/serialization.hpp>
+
+namespace bf {
+
+namespace {
+
+typedef bitvector::block_type block_type;
+
+// The number of blocks ORed from every input before moving on, so that the
+// chunk of the result stays in the L1 cache.
+size_t const chunk_blocks = 4096;
+
+// The number of cells per chunk of counters. A multiple of the block size
+// keeps threads from sharing blocks for every cell width.
+size_t const chunk_cells = 64 * 512;
+
+// ORs the blocks of all inputs into the result. The inputs may be unaligned,
+// e.g., when they point into a memory-mapped file.
+void unite(block_type* result, size_t blocks,
+           std::vector<char const*> const& inputs, size_t threads) {
+  assert(threads > 0);
+  run_threads(threads, [&](size_t t) {
+    auto begin = blocks * t / threads;
+    auto end = blocks * (t + 1) / threads;
+    for (auto first = begin; first < end; first += chunk_blocks) {
+      auto last = std::min(first + chunk_blocks, end);
+      for (auto input : inputs)
+        for (auto i = first; i < last; ++i) {
+          block_type x;
+          std::memcpy(&x, input + i * sizeof(block_type), sizeof(x));
+          result[i] |= x;
+        }
+    }
+  });
+}
+
+// A filter serialized by basic_bloom_filter::save.
+struct serialized_filter
+{
+  serialized_filter(std::string const& filename) : file(filename)
+  {
+    reader source{file.data(), file.size()};
+    source.read_header(serialization_tag::basic_bloom_filter);
+    descriptor = read_descriptor(source);
+    fingerprint = source.read<uint64_t>();
+    cells = source.read<uint64_t>();
+    auto size = cell_bytes(source, cells);
+    blocks = static_cast<char const*>(source.skip(size));
+  }
+
+  mapped_file file;
+  hasher_descriptor descriptor;
+  uint64_t fingerprint;
+  size_t cells;
+  char const* blocks;
+};
+
+} // namespace <anonymous>
+
+basic_bloom_filter merge(std::vector<basic_bloom_filter const*> const& filters,
+                         size_t threads) {
+  if (filters.empty())
+    throw std::invalid_argument("no filters to merge");
+  auto& front = *filters.front();
+  std::vector<char const*> inputs;
+  for (auto f : filters) {
+    if (!f->compatible(front))
+      throw std::invalid_argument("cannot merge incompatible filters");
+    inputs.push_back(reinterpret_cast<char const*>(f->storage().data()));
+  }
+  bitvector bits(front.storage().size());
+  unite(bits.data(), bits.blocks(), inputs, threads);
+  return {front.hasher_function(), std::move(bits), front.partitioned()};
+}
+
+counting_bloom_filter
+merge(std::vector<counting_bloom_filter const*> const& filters,
+      size_t threads) {
+  assert(threads > 0);
+  if (filters.empty())
+    throw std::invalid_argument("no filters to merge");
+  auto& front = *filters.front();
+  for (auto f : filters)
+    if (!f->compatible(front))
+      throw std::invalid_argument("cannot merge incompatible filters");
+  counter_vector cells(front.storage().size(), front.storage().width());
+  auto chunks = (cells.size() + chunk_cells - 1) / chunk_cells;
+  run_threads(threads, [&](size_t t) {
+    for (auto c = chunks * t / threads; c < chunks * (t + 1) / threads; ++c) {
+      auto first = c * chunk_cells;
+      auto last = std::min(first + chunk_cells, cells.size());
+      for (auto f : filters)
+        cells.add_range(f->storage(), first, last);
+    }
+  });
+  return {front.hasher_function(), std::move(cells), front.partitioned()};
+}
+
+basic_bloom_filter merge_files(std::vector<std::string> const& filenames,
+                               hasher h, size_t threads) {
+  if (filenames.empty())
+    throw std::invalid_argument("no filters to merge");
+  auto id = fingerprint(h);
+  std::vector<std::unique_ptr<serialized_filter>> files;
+  std::vector<char const*> inputs;
+  for (auto& filename : filenames) {
+    files.emplace_back(new serialized_filter{filename});
+    auto& f = *files.back();
+    auto& front = *files.front();
+    if (f.cells != front.cells
+        || f.descriptor.mapping != front.descriptor.mapping
+        || f.fingerprint != id)
+      throw std::invalid_argument("cannot merge incompatible filters: "
+                                  + filename);
+    inputs.push_back(f.blocks);
+  }
+  bitvector bits(files.front()->cells);
+  unite(bits.data(), bits.blocks(), inputs, threads);
+  auto partition = files.front()->descriptor.mapping
+                   == hasher_descriptor::partitioned;
+  return {std::move(h), std::move(bits), partition};
+}
+
+basic_bloom_filter merge_files(std::vector<std::string> const& filenames,
+                               size_t threads) {
+  if (filenames.empty())
+    throw std::invalid_argument("no filters to merge");
+  auto d = serialized_filter{filenames.front()}.descriptor;
+  if (d.family == hasher_descriptor::custom)
+    throw std::invalid_argument("cannot rebuild a custom hasher");
+  return merge_files(filenames, make_hasher(d), threads);
+}
+
+} // namespace bf
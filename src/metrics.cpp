@@ -0,0 +1,85 @@
+#include <bf/metrics.hpp>
+
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace bf {
+
+namespace {
+
+size_t const cache_line = 64;
+
+// The next identifier of event counters, starting at 1 so that the zeroed
+// thread-local cache matches no counters.
+std::atomic<uint64_t> next_id{1};
+
+} // namespace <anonymous>
+
+struct event_counters::state
+{
+  std::mutex mutex;
+  std::vector<std::pair<std::thread::id, slot*>> slots;
+  std::vector<std::unique_ptr<char[]>> storage;
+  std::atomic<size_t> baseline[events];
+};
+
+constexpr size_t event_counters::events;
+constexpr size_t event_counters::cache_size;
+
+thread_local event_counters::cache_entry
+  event_counters::cache[event_counters::cache_size];
+
+event_counters::event_counters() : id_(next_id++), state_(new state) {
+  for (auto& b : state_->baseline)
+    b.store(0, std::memory_order_relaxed);
+}
+
+event_counters::~event_counters() = default;
+event_counters::event_counters(event_counters&&) = default;
+event_counters& event_counters::operator=(event_counters&&) = default;
+
+size_t event_counters::total(event e) const {
+  auto i = static_cast<size_t>(e);
+  size_t n = 0;
+  std::lock_guard<std::mutex> lock{state_->mutex};
+  for (auto& s : state_->slots)
+    n += s.second->counts[i].load(std::memory_order_relaxed);
+  return n - state_->baseline[i].load(std::memory_order_relaxed);
+}
+
+void event_counters::reset() {
+  // Other threads may be recording, so rather than clearing their slots,
+  // count from the current totals onward.
+  for (size_t i = 0; i < events; ++i)
+    state_->baseline[i].fetch_add(total(static_cast<event>(i)),
+                                  std::memory_order_relaxed);
+}
+
+event_counters::slot& event_counters::attach() const {
+  auto self = std::this_thread::get_id();
+  slot* result = nullptr;
+  {
+    std::lock_guard<std::mutex> lock{state_->mutex};
+    for (auto& s : state_->slots)
+      if (s.first == self)
+        result = s.second;
+    if (result == nullptr) {
+      // Align the slot to a cache line, which new does not guarantee.
+      auto bytes = sizeof(slot) + 2 * cache_line;
+      std::unique_ptr<char[]> raw{new char[bytes]};
+      void* p = raw.get();
+      std::align(cache_line, sizeof(slot), p, bytes);
+      result = static_cast<slot*>(p);
+      for (auto& c : result->counts)
+        c.store(0, std::memory_order_relaxed);
+      state_->storage.push_back(std::move(raw));
+      state_->slots.emplace_back(self, result);
+    }
+  }
+  cache[id_ % cache_size] = {id_, result};
+  return *result;
+}
+
+} // namespace bf
@@ -0,0 +1,131 @@
+#include <bf/serialization.hpp>
+
+#include <istream>
+#include <iterator>
+#include <limits>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <bf/bitvector.hpp>
+
+namespace bf {
+
+namespace {
+
+uint32_t const magic = 0x6662696c; // "libf" in little endian.
+uint32_t const version = 1;
+
+} // namespace <anonymous>
+
+void write_header(std::ostream& out, serialization_tag tag) {
+  write(out, magic);
+  write(out, version);
+  write(out, static_cast<uint32_t>(tag));
+}
+
+reader::reader(void const* data, size_t size)
+    : data_(static_cast<char const*>(data)), size_(size) {
+}
+
+void reader::read_header(serialization_tag tag) {
+  if (read<uint32_t>() != magic)
+    throw std::runtime_error("not a libbf data structure");
+  if (read<uint32_t>() != version)
+    throw std::runtime_error("unsupported serialization version");
+  if (read<uint32_t>() != static_cast<uint32_t>(tag))
+    throw std::runtime_error("unexpected data structure type");
+}
+
+void const* reader::skip(size_t n) {
+  if (n > size_)
+    throw std::runtime_error("truncated input");
+  auto p = data_;
+  data_ += n;
+  size_ -= n;
+  return p;
+}
+
+size_t reader::remaining() const {
+  return size_;
+}
+
+mapped_file::mapped_file(std::string const& filename) {
+  auto fd = ::open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    throw std::runtime_error("cannot open " + filename);
+  struct stat st;
+  if (::fstat(fd, &st) != 0) {
+    ::close(fd);
+    throw std::runtime_error("cannot stat " + filename);
+  }
+  size_ = st.st_size;
+  if (size_ > 0) {
+    data_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+    if (data_ == MAP_FAILED) {
+      ::close(fd);
+      throw std::runtime_error("cannot map " + filename);
+    }
+  }
+  ::close(fd);
+}
+
+mapped_file::~mapped_file() {
+  if (data_)
+    ::munmap(data_, size_);
+}
+
+void const* mapped_file::data() const {
+  return data_;
+}
+
+size_t mapped_file::size() const {
+  return size_;
+}
+
+void write_descriptor(std::ostream& out, hasher_descriptor const& d) {
+  write<uint32_t>(out, d.family);
+  write<uint32_t>(out, d.mapping);
+  write<uint64_t>(out, d.k);
+  write<uint64_t>(out, d.seed);
+  write<uint64_t>(out, d.double_hashing);
+}
+
+hasher_descriptor read_descriptor(reader& source) {
+  hasher_descriptor d;
+  auto family = source.read<uint32_t>();
+  auto mapping = source.read<uint32_t>();
+  if (family > hasher_descriptor::h3
+      || mapping > hasher_descriptor::partitioned)
+    throw std::runtime_error("invalid hasher descriptor");
+  d.family = static_cast<hasher_descriptor::family_type>(family);
+  d.mapping = static_cast<hasher_descriptor::mapping_type>(mapping);
+  d.k = source.read<uint64_t>();
+  d.seed = source.read<uint64_t>();
+  d.double_hashing = source.read<uint64_t>() != 0;
+  return d;
+}
+
+size_t cell_bytes(reader const& source, uint64_t cells, uint64_t width) {
+  if (cells == 0 || width == 0 || width > 64)
+    throw std::runtime_error("invalid number of cells");
+  auto block_bits = bitvector::bits_per_block;
+  if (cells > (std::numeric_limits<uint64_t>::max() - block_bits) / width)
+    throw std::runtime_error("truncated input");
+  auto blocks = (cells * width + block_bits - 1) / block_bits;
+  if (blocks > source.remaining() / sizeof(bitvector::block_type))
+    throw std::runtime_error("truncated input");
+  return blocks * sizeof(bitvector::block_type);
+}
+
+std::shared_ptr<std::vector<char>> slurp(std::istream& in) {
+  auto buffer = std::make_shared<std::vector<char>>();
+  buffer->assign(std::istreambuf_iterator<char>(in),
+                 std::istreambuf_iterator<char>());
+  return buffer;
+}
+
+} // namespace bf
@@ -0,0 +1,162 @@
+#include <bf/static_function.hpp>
+
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include <bf/serialization.hpp>
+
+namespace bf {
+
+namespace {
+
+// Masks each value with bits of its key's hash, so that lookups of keys
+// outside the construction set yield unrelated values.
+uint64_t value_mask(uint64_t h) {
+  return h ^ (h >> 32);
+}
+
+// Values are bit-packed, so a value of at most 16 bits spans at most three
+// bytes. The value array carries two bytes of padding to read them at once.
+size_t const padding = 2;
+
+size_t packed_size(size_t slots, size_t bits) {
+  return (slots * bits + 7) / 8;
+}
+
+uint64_t load_value(unsigned char const* data, size_t slot, size_t bits) {
+  auto bit = slot * bits;
+  auto p = data + bit / 8;
+  uint32_t x = p[0] | (p[1] << 8) | (uint32_t(p[2]) << 16);
+  return (x >> (bit % 8)) & ((uint32_t(1) << bits) - 1);
+}
+
+void store_value(unsigned char* data, size_t slot, size_t bits, uint64_t v) {
+  auto bit = slot * bits;
+  auto p = data + bit / 8;
+  auto shift = bit % 8;
+  uint32_t mask = ((uint32_t(1) << bits) - 1) << shift;
+  uint32_t x = p[0] | (p[1] << 8) | (uint32_t(p[2]) << 16);
+  x = (x & ~mask) | ((static_cast<uint32_t>(v) << shift) & mask);
+  p[0] = x & 0xff;
+  p[1] = (x >> 8) & 0xff;
+  p[2] = (x >> 16) & 0xff;
+}
+
+size_t const max_attempts = 100;
+
+} // namespace <anonymous>
+
+static_function::static_function(size_t value_bits, size_t seed)
+    : seed_(seed),
+      hash_(seed),
+      bits_(value_bits) {
+  if (value_bits == 0 || value_bits > 16)
+    throw std::invalid_argument("values must have between 1 and 16 bits");
+}
+
+static_function static_function::load(std::istream& in) {
+  auto buffer = slurp(in);
+  reader source{buffer->data(), buffer->size()};
+  source.read_header(serialization_tag::static_function);
+  auto seed = source.read<uint64_t>();
+  auto bits = source.read<uint64_t>();
+  if (bits == 0 || bits > 16)
+    throw std::runtime_error("corrupt static function");
+  static_function f(bits, seed);
+  f.size_ = source.read<uint64_t>();
+  f.mix_ = source.read<uint64_t>();
+  auto segment_length = source.read<uint64_t>();
+  auto segment_count_length = source.read<uint64_t>();
+  auto slots = source.read<uint64_t>();
+  f.graph_ = fuse_graph{segment_length, segment_count_length, slots};
+  auto bytes = packed_size(slots, bits);
+  auto data = static_cast<unsigned char const*>(source.skip(bytes));
+  f.values_.assign(data, data + bytes);
+  f.values_.resize(bytes + padding, 0);
+  return f;
+}
+
+uint64_t static_function::lookup(object const& o) const {
+  if (size_ == 0)
+    return 0;
+  auto h = murmur64(hash_(o) + mix_);
+  size_t slots[3];
+  graph_.locate(h, slots);
+  auto v = value_mask(h);
+  for (auto s : slots)
+    v ^= load_value(values_.data(), s, bits_);
+  return v & ((uint64_t(1) << bits_) - 1);
+}
+
+void static_function::save(std::ostream& out) const {
+  write_header(out, serialization_tag::static_function);
+  write<uint64_t>(out, seed_);
+  write<uint64_t>(out, bits_);
+  write<uint64_t>(out, size_);
+  write<uint64_t>(out, mix_);
+  write<uint64_t>(out, graph_.segment_length());
+  write<uint64_t>(out, graph_.segment_count_length());
+  write<uint64_t>(out, graph_.slots());
+  out.write(reinterpret_cast<char const*>(values_.data()),
+            values_.size() - padding);
+}
+
+size_t static_function::size() const {
+  return size_;
+}
+
+size_t static_function::slots() const {
+  return graph_.slots();
+}
+
+size_t static_function::value_bits() const {
+  return bits_;
+}
+
+void static_function::build(
+  std::vector<std::pair<uint64_t, uint64_t>> entries) {
+  auto max_value = (uint64_t(1) << bits_) - 1;
+  std::sort(entries.begin(), entries.end());
+  size_t n = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (entries[i].second > max_value)
+      throw std::invalid_argument("value exceeds value width");
+    if (n > 0 && entries[n - 1].first == entries[i].first) {
+      if (entries[n - 1].second != entries[i].second)
+        throw std::invalid_argument("key maps to different values");
+      continue;
+    }
+    entries[n++] = entries[i];
+  }
+  entries.resize(n);
+  size_ = n;
+  graph_ = fuse_graph{size_};
+  values_.assign(packed_size(graph_.slots(), bits_) + padding, 0);
+  std::vector<uint64_t> hashes(size_);
+  std::vector<fuse_graph::peeled> order;
+  std::minstd_rand0 prng(seed_);
+  for (size_t attempt = 0; attempt < max_attempts; ++attempt) {
+    mix_ = (static_cast<uint64_t>(prng()) << 32) | prng();
+    for (size_t i = 0; i < size_; ++i)
+      hashes[i] = murmur64(entries[i].first + mix_);
+    if (!graph_.peel(hashes, order))
+      continue;
+    // Assign values in reverse peeling order, so that each key's free slot
+    // is written after all slots it depends on.
+    auto data = values_.data();
+    size_t slots[3];
+    for (auto i = order.rbegin(); i != order.rend(); ++i) {
+      auto h = hashes[i->first];
+      graph_.locate(h, slots);
+      auto v = entries[i->first].second ^ value_mask(h);
+      for (uint8_t j = 0; j < 3; ++j)
+        if (j != i->second)
+          v ^= load_value(data, slots[j], bits_);
+      store_value(data, slots[i->second], bits_, v);
+    }
+    return;
+  }
+  throw std::runtime_error("failed to construct static function");
+}
+
+} // namespace bf
@@ -0,0 +1,566 @@
+// Microbenchmarks for the primitives and filters of libbf.
+//
+// Every line of output reports one operation of one data structure at one
+// configuration (number of keys, key size, fraction of lookups that hit,
+// number of threads) as CSV or JSON lines, so that runs can be diffed to
+// track regressions. Cycles are reference cycles from the time-stamp
+// counter, and zero on platforms without one.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "bf/all.hpp"
+
+using namespace bf;
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+uint64_t cycles() {
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return 0;
+#endif
+}
+
+// Prevents the compiler from discarding the results of measured operations.
+std::atomic<size_t> sink{0};
+
+struct options {
+  size_t small = 1 << 14;
+  size_t large = 1 << 22;
+  size_t queries = 1 << 18;
+  std::vector<size_t> threads;
+  std::string only;
+  bool json = false;
+};
+
+struct sample {
+  size_t ops;
+  double seconds;
+  uint64_t cycles;
+};
+
+struct setting {
+  size_t n;
+  size_t key_bytes;
+  double hit_ratio;
+  size_t threads;
+};
+
+class report {
+public:
+  explicit report(bool json) : json_(json) {
+    if (!json_)
+      std::cout << "structure,op,n,key_bytes,hit_ratio,threads,ops,ns_per_op,"
+                   "ops_per_s,cycles_per_op,bytes_per_key\n";
+  }
+
+  void emit(std::string const& structure, std::string const& op,
+            setting const& s, sample const& x, double bytes) {
+    auto ns = x.seconds * 1e9 / x.ops;
+    auto rate = x.ops / x.seconds;
+    auto cpo = static_cast<double>(x.cycles) / x.ops;
+    auto bpk = bytes / s.n;
+    std::ostringstream line;
+    if (json_)
+      line << "{\"structure\":\"" << structure << "\",\"op\":\"" << op
+           << "\",\"n\":" << s.n << ",\"key_bytes\":" << s.key_bytes
+           << ",\"hit_ratio\":" << s.hit_ratio << ",\"threads\":"
+           << s.threads << ",\"ops\":" << x.ops << ",\"ns_per_op\":" << ns
+           << ",\"ops_per_s\":" << rate << ",\"cycles_per_op\":" << cpo
+           << ",\"bytes_per_key\":" << bpk << "}";
+    else
+      line << structure << ',' << op << ',' << s.n << ',' << s.key_bytes
+           << ',' << s.hit_ratio << ',' << s.threads << ',' << x.ops << ','
+           << ns << ',' << rate << ',' << cpo << ',' << bpk;
+    std::cout << line.str() << std::endl;
+  }
+
+private:
+  bool json_;
+};
+
+// Times a single-threaded operation that performs *ops* operations.
+sample measure(size_t ops, std::function<void()> const& f) {
+  auto start = clock_type::now();
+  auto c0 = cycles();
+  f();
+  auto c1 = cycles();
+  std::chrono::duration<double> d = clock_type::now() - start;
+  return {ops, d.count(), c1 - c0};
+}
+
+// Times *threads* concurrent invocations of an operation that performs
+// *ops* operations each, from a common start until the last one finishes.
+sample measure(size_t threads, size_t ops,
+               std::function<void(size_t)> const& f) {
+  if (threads == 1)
+    return measure(ops, [&] { f(0); });
+  std::atomic<size_t> ready{0};
+  std::atomic<bool> go{false};
+  std::vector<std::thread> workers;
+  for (size_t t = 0; t < threads; ++t)
+    workers.emplace_back([&, t] {
+      ++ready;
+      while (!go)
+        std::this_thread::yield();
+      f(t);
+    });
+  while (ready < threads)
+    std::this_thread::yield();
+  auto start = clock_type::now();
+  auto c0 = cycles();
+  go = true;
+  for (auto& w : workers)
+    w.join();
+  auto c1 = cycles();
+  std::chrono::duration<double> d = clock_type::now() - start;
+  return {threads * ops, d.count(), c1 - c0};
+}
+
+// A set of fixed-size random keys in contiguous memory.
+class keyset {
+public:
+  keyset(size_t n, size_t width, uint64_t seed)
+    : width_(width), bytes_(n * width) {
+    std::mt19937_64 prng(seed);
+    for (size_t i = 0; i < bytes_.size(); i += 8) {
+      auto x = prng();
+      std::memcpy(&bytes_[i], &x, std::min<size_t>(8, bytes_.size() - i));
+    }
+  }
+
+  object operator[](size_t i) const {
+    return {&bytes_[i * width_], width_};
+  }
+
+  size_t size() const {
+    return bytes_.size() / width_;
+  }
+
+private:
+  size_t width_;
+  std::vector<unsigned char> bytes_;
+};
+
+// Draws queries of which a given fraction hits the inserted keys.
+std::vector<object> make_queries(keyset const& hits, keyset const& misses,
+                                 size_t n, double hit_ratio, uint64_t seed) {
+  std::mt19937_64 prng(seed);
+  std::vector<object> queries;
+  queries.reserve(n);
+  auto h = static_cast<size_t>(n * hit_ratio);
+  for (size_t i = 0; i < n; ++i) {
+    auto& from = i < h ? hits : misses;
+    queries.push_back(from[prng() % from.size()]);
+  }
+  std::shuffle(queries.begin(), queries.end(), prng);
+  return queries;
+}
+
+std::vector<size_t> make_indices(size_t n, size_t range, uint64_t seed) {
+  std::mt19937_64 prng(seed);
+  std::vector<size_t> indices(n);
+  for (auto& i : indices)
+    i = prng() % range;
+  return indices;
+}
+
+// Describes how to construct a filter and what it supports.
+struct filter_spec {
+  std::string name;
+  /// Constructs an empty filter for dynamic filters, and the complete
+  /// filter for static ones. Sets the second argument to the bytes used.
+  std::function<std::unique_ptr<bloom_filter>(keyset const&, double&)> make;
+  bool dynamic;
+  std::function<void(bloom_filter&, object const&)> remove;
+};
+
+std::vector<filter_spec> make_specs(size_t n) {
+  auto fp = 0.01;
+  auto m = basic_bloom_filter::m(fp, n);
+  auto k = basic_bloom_filter::k(m, n);
+  std::vector<filter_spec> specs;
+  specs.push_back({"basic", [=](keyset const&, double& bytes) {
+    bytes = m / 8.0;
+    return std::unique_ptr<bloom_filter>(new basic_bloom_filter(fp, n));
+  }, true, nullptr});
+  specs.push_back({"basic-unpartitioned", [=](keyset const&, double& bytes) {
+    bytes = m / 8.0;
+    return std::unique_ptr<bloom_filter>(
+      new basic_bloom_filter(make_hasher(k, 0, true), m, false));
+  }, true, [](bloom_filter& f, object const& o) {
+    static_cast<basic_bloom_filter&>(f).remove(o);
+  }});
+  specs.push_back({"counting", [=](keyset const&, double& bytes) {
+    bytes = m * 4 / 8.0;
+    return std::unique_ptr<bloom_filter>(
+      new counting_bloom_filter(make_hasher(k, 0, true), m, 4));
+  }, true, [](bloom_filter& f, object const& o) {
+    static_cast<counting_bloom_filter&>(f).remove(o);
+  }});
+  specs.push_back({"spectral-mi", [=](keyset const&, double& bytes) {
+    bytes = m * 4 / 8.0;
+    return std::unique_ptr<bloom_filter>(
+      new spectral_mi_bloom_filter(make_hasher(k, 0, true), m, 4));
+  }, true, nullptr});
+  specs.push_back({"stable", [=](keyset const&, double& bytes) {
+    bytes = m * 2 / 8.0;
+    return std::unique_ptr<bloom_filter>(
+      new stable_bloom_filter(make_hasher(k, 0, true), m, 2, 10));
+  }, true, nullptr});
+  specs.push_back({"a2", [=](keyset const&, double& bytes) {
+    auto k2 = a2_bloom_filter::k(fp);
+    auto cells = 2 * ((m + 1) / 2);
+    bytes = cells / 8.0;
+    return std::unique_ptr<bloom_filter>(new a2_bloom_filter(
+      k2, cells, a2_bloom_filter::capacity(fp, cells / 2), 0, 1));
+  }, true, nullptr});
+  specs.push_back({"bitwise", [=](keyset const&, double& bytes) {
+    bytes = m / 8.0;
+    return std::unique_ptr<bloom_filter>(new bitwise_bloom_filter(k, m));
+  }, true, nullptr});
+  specs.push_back({"scalable", [=](keyset const&, double& bytes) {
+    bytes = basic_bloom_filter::m(fp * 0.15, n) / 8.0;
+    return std::unique_ptr<bloom_filter>(new scalable_bloom_filter(fp, n));
+  }, true, nullptr});
+  specs.push_back({"cuckoo", [=](keyset const&, double& bytes) {
+    bytes = cuckoo_filter::buckets(n) * cuckoo_filter::bucket_size
+            * cuckoo_filter::fingerprint_bits(fp) / 8.0;
+    return std::unique_ptr<bloom_filter>(new cuckoo_filter(fp, n));
+  }, true, [](bloom_filter& f, object const& o) {
+    static_cast<cuckoo_filter&>(f).remove(o);
+  }});
+  specs.push_back({"counting-quotient", [=](keyset const&, double& bytes) {
+    auto f = new counting_quotient_filter(fp, n);
+    bytes = f->slots() * f->slot_bits() / 8.0;
+    return std::unique_ptr<bloom_filter>(f);
+  }, true, [](bloom_filter& f, object const& o) {
+    static_cast<counting_quotient_filter&>(f).remove(o);
+  }});
+  specs.push_back({"count-min", [=](keyset const&, double& bytes) {
+    auto width = count_min_sketch::width(0.001);
+    bytes = width * 4 * 4.0;
+    return std::unique_ptr<bloom_filter>(new count_min_sketch(width, 4));
+  }, true, nullptr});
+  specs.push_back({"age-partitioned", [=](keyset const&, double& bytes) {
+    auto f = new age_partitioned_bloom_filter(fp, n);
+    bytes = (f->k() + f->l()) * f->cells() / 8.0;
+    return std::unique_ptr<bloom_filter>(f);
+  }, true, nullptr});
+  specs.push_back({"expiring", [=](keyset const&, double& bytes) {
+    auto width = expiring_bloom_filter::width(16);
+    bytes = m * width / 8.0;
+    return std::unique_ptr<bloom_filter>(
+      new expiring_bloom_filter(make_hasher(k, 0, true), m, width, 16));
+  }, true, nullptr});
+  specs.push_back({"binary-fuse", [=](keyset const& keys, double& bytes) {
+    std::vector<object> os;
+    for (size_t i = 0; i < keys.size(); ++i)
+      os.push_back(keys[i]);
+    auto f = new binary_fuse_filter(os.begin(), os.end());
+    bytes = f->slots();
+    return std::unique_ptr<bloom_filter>(f);
+  }, false, nullptr});
+  specs.push_back({"ribbon", [=](keyset const& keys, double& bytes) {
+    std::vector<object> os;
+    for (size_t i = 0; i < keys.size(); ++i)
+      os.push_back(keys[i]);
+    auto f = new ribbon_filter(os.begin(), os.end(), 7);
+    bytes = f->slots() * 7 / 8.0;
+    return std::unique_ptr<bloom_filter>(f);
+  }, false, nullptr});
+  return specs;
+}
+
+bool selected(options const& opts, std::string const& name) {
+  return opts.only.empty() || name.find(opts.only) != std::string::npos;
+}
+
+void bench_hashers(options const& opts, report& out, keyset const& keys,
+                   setting s) {
+  auto q = opts.queries;
+  auto n = keys.size();
+  if (selected(opts, "h3")) {
+    default_hash_function h(0);
+    out.emit("h3", "hash", s, measure(q, [&] {
+      size_t x = 0;
+      for (size_t i = 0; i < q; ++i)
+        x += h(keys[i % n]);
+      sink += x;
+    }), 0);
+  }
+  for (auto double_hashing : {false, true}) {
+    auto name = double_hashing ? "double-hasher" : "default-hasher";
+    if (!selected(opts, name))
+      continue;
+    auto h = make_hasher(7, 0, double_hashing);
+    out.emit(name, "hash-k7", s, measure(q, [&] {
+      size_t x = 0;
+      for (size_t i = 0; i < q; ++i)
+        x += h(keys[i % n])[0];
+      sink += x;
+    }), 0);
+  }
+}
+
+void bench_vectors(options const& opts, report& out, setting s) {
+  auto cells = 10 * s.n;
+  auto idx = make_indices(opts.queries, cells, 7);
+  auto q = idx.size();
+  if (selected(opts, "bitvector")) {
+    bitvector b(cells);
+    out.emit("bitvector", "set", s, measure(q, [&] {
+      for (auto i : idx)
+        b.set(i);
+    }), cells / 8.0);
+    out.emit("bitvector", "test", s, measure(q, [&] {
+      size_t x = 0;
+      for (auto i : idx)
+        x += b[i];
+      sink += x;
+    }), cells / 8.0);
+    out.emit("bitvector", "count", s, measure(cells, [&] {
+      sink += b.count();
+    }), cells / 8.0);
+  }
+  if (selected(opts, "counter_vector")) {
+    counter_vector v(cells, 4);
+    out.emit("counter_vector", "increment", s, measure(q, [&] {
+      for (auto i : idx)
+        v.increment(i);
+    }), cells * 4 / 8.0);
+    out.emit("counter_vector", "count", s, measure(q, [&] {
+      size_t x = 0;
+      for (auto i : idx)
+        x += v.count(i);
+      sink += x;
+    }), cells * 4 / 8.0);
+    out.emit("counter_vector", "decrement", s, measure(q, [&] {
+      for (auto i : idx)
+        v.decrement(i);
+    }), cells * 4 / 8.0);
+  }
+}
+
+void bench_filters(options const& opts, report& out, keyset const& keys,
+                   keyset const& misses, setting s) {
+  for (auto& spec : make_specs(s.n)) {
+    if (!selected(opts, spec.name))
+      continue;
+    double bytes = 0;
+    std::unique_ptr<bloom_filter> f;
+    if (spec.dynamic) {
+      f = spec.make(keys, bytes);
+      auto& filter = *f;
+      s.hit_ratio = 0;
+      s.threads = 1;
+      out.emit(spec.name, "add", s, measure(s.n, [&] {
+        for (size_t i = 0; i < s.n; ++i)
+          filter.add(keys[i]);
+      }), bytes);
+    } else {
+      s.hit_ratio = 0;
+      s.threads = 1;
+      auto x = measure(s.n, [&] { f = spec.make(keys, bytes); });
+      out.emit(spec.name, "build", s, x, bytes);
+    }
+    auto& filter = *f;
+    for (auto hit_ratio : {0.0, 0.5, 1.0}) {
+      auto queries = make_queries(keys, misses, opts.queries, hit_ratio, 42);
+      s.hit_ratio = hit_ratio;
+      for (auto threads : opts.threads) {
+        s.threads = threads;
+        out.emit(spec.name, "lookup", s, measure(threads, queries.size(),
+                 [&](size_t) {
+          size_t x = 0;
+          for (auto& q : queries)
+            x += filter.lookup(q);
+          sink += x;
+        }), bytes);
+      }
+      s.threads = 1;
+      out.emit(spec.name, "lookup-batch", s, measure(queries.size(), [&] {
+        auto r = filter.lookup(queries);
+        sink += r.size();
+      }), bytes);
+    }
+    if (spec.remove) {
+      s.hit_ratio = 1;
+      s.threads = 1;
+      out.emit(spec.name, "remove", s, measure(s.n, [&] {
+        for (size_t i = 0; i < s.n; ++i)
+          spec.remove(filter, keys[i]);
+      }), bytes);
+    }
+  }
+}
+
+void bench_others(options const& opts, report& out, keyset const& keys,
+                  keyset const& misses, setting s) {
+  auto queries = make_queries(keys, misses, opts.queries, 0.5, 42);
+  s.threads = 1;
+  if (selected(opts, "static-function")) {
+    std::vector<std::pair<object, uint64_t>> entries;
+    for (size_t i = 0; i < keys.size(); ++i)
+      entries.emplace_back(keys[i], i & 0xff);
+    std::unique_ptr<static_function> f;
+    s.hit_ratio = 0;
+    auto x = measure(s.n, [&] {
+      f.reset(new static_function(entries.begin(), entries.end()));
+    });
+    out.emit("static-function", "build", s, x, f->slots());
+    s.hit_ratio = 0.5;
+    out.emit("static-function", "lookup", s, measure(queries.size(), [&] {
+      size_t x = 0;
+      for (auto& q : queries)
+        x += f->lookup(q);
+      sink += x;
+    }), f->slots());
+  }
+  if (selected(opts, "iblt")) {
+    auto cells = iblt::cells(s.n);
+    iblt t(cells);
+    std::vector<uint64_t> ids(s.n);
+    for (size_t i = 0; i < s.n; ++i)
+      std::memcpy(&ids[i], keys[i].data(), std::min<size_t>(8, s.key_bytes));
+    s.hit_ratio = 0;
+    auto bytes = cells * 24.0;
+    out.emit("iblt", "add", s, measure(s.n, [&] {
+      for (auto id : ids)
+        t.insert(id);
+    }), bytes);
+    s.hit_ratio = 1;
+    out.emit("iblt", "remove", s, measure(s.n, [&] {
+      for (auto id : ids)
+        t.erase(id);
+    }), bytes);
+  }
+  // The range filter takes integer keys, so it only runs for 8-byte keys.
+  if (s.key_bytes == 8 && selected(opts, "range")) {
+    auto fp = 0.01;
+    range_bloom_filter f(fp, s.n, 64);
+    auto bytes = f.levels() * basic_bloom_filter::m(fp / 4, s.n) / 8.0;
+    std::vector<uint64_t> ids(s.n);
+    for (size_t i = 0; i < s.n; ++i)
+      std::memcpy(&ids[i], keys[i].data(), 8);
+    s.hit_ratio = 0;
+    out.emit("range", "add", s, measure(s.n, [&] {
+      for (auto id : ids)
+        f.add(id);
+    }), bytes);
+    std::vector<range_bloom_filter::range> ranges;
+    for (auto& q : queries) {
+      uint64_t lo;
+      std::memcpy(&lo, q.data(), 8);
+      lo -= std::min<uint64_t>(lo, 31);
+      ranges.emplace_back(lo, lo + 63);
+    }
+    s.hit_ratio = 0.5;
+    out.emit("range", "lookup", s, measure(queries.size(), [&] {
+      size_t x = 0;
+      for (auto& q : queries) {
+        uint64_t id;
+        std::memcpy(&id, q.data(), 8);
+        x += f.lookup(id);
+      }
+      sink += x;
+    }), bytes);
+    out.emit("range", "lookup-range", s, measure(ranges.size(), [&] {
+      size_t x = 0;
+      for (auto& r : ranges)
+        x += f.lookup_range(r.first, r.second);
+      sink += x;
+    }), bytes);
+    out.emit("range", "lookup-range-batch", s, measure(ranges.size(), [&] {
+      sink += f.lookup_range(ranges).size();
+    }), bytes);
+  }
+}
+
+std::vector<size_t> parse_list(char const* str) {
+  std::vector<size_t> xs;
+  std::istringstream in(str);
+  std::string item;
+  while (std::getline(in, item, ','))
+    xs.push_back(std::strtoull(item.c_str(), nullptr, 10));
+  return xs;
+}
+
+void usage(char const* program) {
+  std::cerr << "usage: " << program
+            << " [--quick] [--json] [--small N] [--large N] [--queries N]"
+               " [--threads T1,T2,...] [--only NAME]\n";
+}
+
+} // namespace <anonymous>
+
+int main(int argc, char* argv[]) {
+  options opts;
+  for (int i = 1; i < argc; ++i) {
+    std::string arg = argv[i];
+    auto value = i + 1 < argc ? argv[i + 1] : nullptr;
+    if (arg == "--quick") {
+      opts.small = 1 << 10;
+      opts.large = 1 << 14;
+      opts.queries = 1 << 12;
+    } else if (arg == "--json") {
+      opts.json = true;
+    } else if (arg == "--small" && value) {
+      opts.small = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--large" && value) {
+      opts.large = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--queries" && value) {
+      opts.queries = std::strtoull(argv[++i], nullptr, 10);
+    } else if (arg == "--threads" && value) {
+      opts.threads = parse_list(argv[++i]);
+    } else if (arg == "--only" && value) {
+      opts.only = argv[++i];
+    } else {
+      usage(argv[0]);
+      return 1;
+    }
+  }
+  if (opts.threads.empty()) {
+    opts.threads.push_back(1);
+    auto hw = std::thread::hardware_concurrency();
+    if (hw > 1)
+      opts.threads.push_back(hw);
+  }
+  report out(opts.json);
+  // The small size fits into the L2 cache, the large one exceeds the last
+  // level cache of most machines. Key sizes span the hash function limit.
+  for (auto n : {opts.small, opts.large}) {
+    for (size_t width : {8, 16, 32}) {
+      if (n == opts.large && width != 8)
+        continue;
+      keyset keys(n, width, 1);
+      keyset misses(n, width, 2);
+      setting s{n, width, 0, 1};
+      bench_hashers(opts, out, keys, s);
+      if (width == 8)
+        bench_vectors(opts, out, s);
+      bench_filters(opts, out, keys, misses, s);
+      bench_others(opts, out, keys, misses, s);
+    }
+  }
+  return 0;
+}
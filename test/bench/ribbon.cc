@@ -0,0 +1,97 @@
+// Compares the space and accuracy of Ribbon filters against basic Bloom
+// filters and the analytical sizing formulas.
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "bf/all.hpp"
+
+using namespace bf;
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+double elapsed_ms(clock_type::time_point start) {
+  auto d = clock_type::now() - start;
+  return std::chrono::duration<double, std::milli>(d).count();
+}
+
+struct result {
+  double bits_per_key;
+  double fp_rate;
+  double build_ms;
+  double lookup_ns;
+};
+
+template <typename Filter>
+result measure(Filter const& f, size_t bits, std::vector<uint64_t> const& keys,
+               std::vector<uint64_t> const& queries, double build_ms) {
+  size_t fn = 0;
+  for (auto k : keys)
+    if (!f.lookup(k))
+      ++fn;
+  if (fn > 0)
+    std::cerr << "warning: " << fn << " false negatives" << std::endl;
+  auto start = clock_type::now();
+  size_t fp = 0;
+  for (auto q : queries)
+    fp += f.lookup(q);
+  auto lookup_ms = elapsed_ms(start);
+  return {static_cast<double>(bits) / keys.size(),
+          static_cast<double>(fp) / queries.size(), build_ms,
+          lookup_ms * 1e6 / queries.size()};
+}
+
+void print(std::string const& name, double target, double formula,
+           result const& r) {
+  std::cout << std::left << std::setw(8) << name << std::right
+            << std::setw(10) << target << std::setw(10) << formula
+            << std::setw(10) << r.bits_per_key << std::setw(12) << r.fp_rate
+            << std::setw(12) << r.build_ms << std::setw(12) << r.lookup_ns
+            << std::endl;
+}
+
+} // namespace <anonymous>
+
+int main(int argc, char* argv[]) {
+  size_t n = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1000000;
+  size_t threads = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+  // Keys are even, queries odd, so every positive query is a false positive.
+  std::vector<uint64_t> keys(n);
+  std::vector<uint64_t> queries(n);
+  for (size_t i = 0; i < n; ++i) {
+    keys[i] = 2 * i;
+    queries[i] = 2 * i + 1;
+  }
+  std::cout << std::setprecision(4) << std::left << std::setw(8) << "filter"
+            << std::right << std::setw(10) << "target" << std::setw(10)
+            << "formula" << std::setw(10) << "bits/key" << std::setw(12)
+            << "fp-rate" << std::setw(12) << "build-ms" << std::setw(12)
+            << "lookup-ns" << std::endl;
+  for (auto fp : {0.01, 0.001, 0.0001}) {
+    // The formula column shows the bits per key that the respective sizing
+    // formula predicts; for Ribbon filters the information-theoretic bound
+    // log2(1/fp) is the lower bound.
+    auto start = clock_type::now();
+    basic_bloom_filter basic(fp, n);
+    for (auto k : keys)
+      basic.add(k);
+    auto build = elapsed_ms(start);
+    auto bits = basic.storage().size();
+    print("basic", fp, static_cast<double>(basic_bloom_filter::m(fp, n)) / n,
+          measure(basic, bits, keys, queries, build));
+    auto r = ribbon_filter::fingerprint_bits(fp);
+    start = clock_type::now();
+    ribbon_filter ribbon(keys.begin(), keys.end(), r, threads);
+    build = elapsed_ms(start);
+    print("ribbon", fp, ribbon_filter::bits_per_key(r),
+          measure(ribbon, ribbon.slots() * r, keys, queries, build));
+    print("bound", fp, -std::log2(fp), {-std::log2(fp), fp, 0, 0});
+  }
+  return 0;
+}
@@ -1,19 +1,26 @@
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstring>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <memory>
+#include <random>
+#include <typeinfo>
 #include <unordered_map>
 
 #include "configuration.h"
+#include "service.h"
 
 #include "bf/all.hpp"
+#include "bf/bulk.hpp"
+#include "bf/serialization.hpp"
 
 using namespace util;
 using namespace bf;
 
-trial<nothing> run(config const& cfg) {
-  auto numeric = cfg.check("numeric");
+trial<std::unique_ptr<bloom_filter>> make_filter(config const& cfg) {
   auto k = *cfg.as<size_t>("hash-functions");
   auto cells = *cfg.as<size_t>("cells");
   auto seed = *cfg.as<size_t>("seed");
@@ -114,31 +121,204 @@ trial<nothing> run(config const& cfg) {
     return error{"invalid bloom filter type"};
   }
 
-  std::string line;
-  auto input_file = *cfg.as<std::string>("input");
-  std::ifstream in{input_file};
-  if (!in)
-    return error{"cannot read " + input_file};
+  return {std::move(bf)};
+}
 
-  in >> std::noskipws;
+trial<std::unique_ptr<bloom_filter>> load_filter(std::string const& filename) {
+  // Dispatch on the type in the header, which follows the magic number and
+  // the version.
+  std::ifstream in{filename, std::ios::binary};
+  uint32_t header[3];
+  if (!in.read(reinterpret_cast<char*>(header), sizeof(header)))
+    return error{"cannot read " + filename};
+  in.close();
+  std::unique_ptr<bloom_filter> bf;
+  try {
+    switch (static_cast<serialization_tag>(header[2])) {
+      default:
+        return error{"not a serialized Bloom filter: " + filename};
+      case serialization_tag::basic_bloom_filter:
+        bf.reset(new basic_bloom_filter(basic_bloom_filter::load(filename)));
+        break;
+      case serialization_tag::counting_bloom_filter:
+        bf.reset(new counting_bloom_filter(
+          counting_bloom_filter::load(filename)));
+        break;
+      case serialization_tag::binary_fuse_filter:
+        bf.reset(new binary_fuse_filter(binary_fuse_filter::load(filename)));
+        break;
+    }
+  } catch (std::exception const& e) {
+    return error{"cannot load " + filename + ": " + e.what()};
+  }
+  return {std::move(bf)};
+}
 
-  while (std::getline(in, line)) {
-    if (line.empty())
-      continue;
+trial<nothing> save_filter(bloom_filter const& bf,
+                           std::string const& filename) {
+  auto& type = typeid(bf);
+  if (type != typeid(basic_bloom_filter)
+      && type != typeid(counting_bloom_filter)
+      && type != typeid(binary_fuse_filter))
+    return error{"cannot save filters of this type"};
+  std::ofstream out{filename, std::ios::binary};
+  if (!out)
+    return error{"cannot write " + filename};
+  if (type == typeid(basic_bloom_filter))
+    static_cast<basic_bloom_filter const&>(bf).save(out);
+  else if (type == typeid(counting_bloom_filter))
+    static_cast<counting_bloom_filter const&>(bf).save(out);
+  else
+    static_cast<binary_fuse_filter const&>(bf).save(out);
+  out.close();
+  if (!out)
+    return error{"cannot write " + filename};
+  return nil;
+}
 
-    auto p = line.data();
-    while (*p)
-      if (*p == ' ' || *p == '\t')
-        return error{"whitespace in input not supported"};
-      else
-        ++p;
+// The elements of one slice of the input. String elements reference the
+// mapped input, numeric elements the parsed numbers.
+struct slice {
+  std::vector<object> elements;
+  std::vector<double> numbers;
+  bool whitespace = false;
+};
+
+// Finds the beginning of the line after a position.
+char const* next_line(char const* p, char const* last) {
+  auto nl = static_cast<char const*>(std::memchr(p, '\n', last - p));
+  return nl ? nl + 1 : last;
+}
 
-    if (numeric)
-      bf->add(std::strtod(line.c_str(), nullptr));
+// Parses the lines of a region that starts at a line boundary.
+void parse(char const* first, char const* last, bool numeric, slice& s) {
+  s.elements.clear();
+  s.numbers.clear();
+  s.whitespace = false;
+  while (first < last) {
+    auto end = next_line(first, last);
+    auto n = end - first - (end[-1] == '\n');
+    if (n > 0) {
+      if (std::memchr(first, ' ', n) || std::memchr(first, '\t', n)) {
+        s.whitespace = true;
+        return;
+      }
+      s.elements.emplace_back(first, n);
+    }
+    first = end;
+  }
+  if (!numeric)
+    return;
+  // The mapping is not NUL-terminated, so copy each number before parsing.
+  s.numbers.resize(s.elements.size());
+  for (size_t i = 0; i < s.elements.size(); ++i) {
+    char buf[64];
+    auto n = std::min(s.elements[i].size(), sizeof(buf) - 1);
+    std::memcpy(buf, s.elements[i].data(), n);
+    buf[n] = '\0';
+    s.numbers[i] = std::strtod(buf, nullptr);
+    s.elements[i] = wrap(s.numbers[i]);
+  }
+}
+
+trial<size_t> ingest(config const& cfg, bloom_filter& bf) {
+  // Bounds the memory for element references, independent of the input size.
+  static size_t const window = 64 << 20;
+  auto numeric = cfg.check("numeric");
+  auto threads = std::max<size_t>(*cfg.as<size_t>("threads"), 1);
+  auto input_file = *cfg.as<std::string>("input");
+  std::unique_ptr<mapped_file> input;
+  try {
+    input.reset(new mapped_file{input_file});
+  } catch (std::runtime_error const&) {
+    return error{"cannot read " + input_file};
+  }
+  // Basic and counting Bloom filters build in bulk, the others in batches.
+  auto add = [&](std::vector<object> const& xs) {
+    if (typeid(bf) == typeid(basic_bloom_filter))
+      static_cast<basic_bloom_filter&>(bf).add(xs.begin(), xs.end(), threads);
+    else if (typeid(bf) == typeid(counting_bloom_filter))
+      static_cast<counting_bloom_filter&>(bf).add(xs.begin(), xs.end(),
+                                                  threads);
     else
-      bf->add(line);
+      bf.add(xs);
+  };
+  auto start = std::chrono::steady_clock::now();
+  auto data = static_cast<char const*>(input->data());
+  auto last = data + input->size();
+  std::vector<slice> slices(threads);
+  std::vector<object> elements;
+  size_t count = 0;
+  for (auto first = data; first < last;) {
+    auto end = next_line(std::min(first + window, last) - 1, last);
+    // Split the window into one region per thread at line boundaries.
+    std::vector<char const*> bounds{first};
+    for (size_t t = 1; t < threads; ++t) {
+      auto p = first + (end - first) * t / threads;
+      bounds.push_back(std::max(bounds.back(),
+                                p > first ? next_line(p - 1, end) : first));
+    }
+    bounds.push_back(end);
+    run_threads(threads, [&](size_t t) {
+      parse(bounds[t], bounds[t + 1], numeric, slices[t]);
+    });
+    elements.clear();
+    for (auto& s : slices) {
+      if (s.whitespace)
+        return error{"whitespace in input not supported"};
+      elements.insert(elements.end(), s.elements.begin(), s.elements.end());
+    }
+    add(elements);
+    count += elements.size();
+    first = end;
   }
+  std::chrono::duration<double> elapsed =
+    std::chrono::steady_clock::now() - start;
+  auto seconds = std::max(elapsed.count(), 1e-9);
+  std::cerr << "ingested " << count << " elements (" << input->size()
+            << " bytes) in " << seconds << " s: "
+            << input->size() / seconds / 1e6 << " MB/s, " << count / seconds
+            << " elements/s" << std::endl;
+  return count;
+}
 
+// Retrieves the size of the cells of a filter in bytes, for every type that
+// the program builds or loads.
+double filter_bytes(bloom_filter const& bf) {
+  if (auto x = dynamic_cast<basic_bloom_filter const*>(&bf))
+    return x->storage().size() / 8.0;
+  // Includes the spectral MI and stable Bloom filters.
+  if (auto x = dynamic_cast<counting_bloom_filter const*>(&bf))
+    return x->storage().size() * x->storage().width() / 8.0;
+  if (auto x = dynamic_cast<spectral_rm_bloom_filter const*>(&bf))
+    return x->bits() / 8.0;
+  if (auto x = dynamic_cast<bitwise_bloom_filter const*>(&bf))
+    return x->bits() / 8.0;
+  if (auto x = dynamic_cast<a2_bloom_filter const*>(&bf))
+    return x->bits() / 8.0;
+  if (auto x = dynamic_cast<binary_fuse_filter const*>(&bf))
+    return x->slots() * x->fingerprint_bits() / 8.0;
+  assert(!"filter_bytes: unknown filter type");
+  return 0;
+}
+
+// Writes a string as JSON string literal.
+void write_json_string(std::ostream& out, std::string const& str) {
+  out << '"';
+  for (auto c : str)
+    if (c == '"' || c == '\\')
+      out << '\\' << c;
+    else if (static_cast<unsigned char>(c) < 0x20)
+      out << "\\u00" << std::hex << std::setw(2) << std::setfill('0')
+          << static_cast<int>(c) << std::dec << std::setfill(' ');
+    else
+      out << c;
+  out << '"';
+}
+
+// Prints the running confusion matrix after every query.
+trial<nothing> query_log(config const& cfg, bloom_filter const& bf) {
+  auto numeric = cfg.check("numeric");
   size_t tn = 0, tp = 0, fp = 0, fn = 0;
   size_t ground_truth;
   std::string element;
@@ -147,14 +327,14 @@ trial<nothing> run(config const& cfg) {
   if (!query)
     return error{"cannot read " + query_file};
 
-  std::cout << "TN TP FP FN G C E" << std::endl;
+  std::cout << "TN TP FP FN G C E\n";
   while (query >> ground_truth >> element) // uniq -c
   {
     size_t count;
     if (numeric)
-      count = bf->lookup(std::strtod(element.c_str(), nullptr));
+      count = bf.lookup(std::strtod(element.c_str(), nullptr));
     else
-      count = bf->lookup(element);
+      count = bf.lookup(element);
 
     if (!query)
       return error{"failed to parse element"};
@@ -176,9 +356,325 @@ trial<nothing> run(config const& cfg) {
     else
       std::cout << element;
 
-    std::cout << std::endl;
+    std::cout << '\n';
+  }
+  std::cout << std::flush;
+
+  return nil;
+}
+
+// Reads all queries, looks them up in a single timed batch, and prints only
+// the final confusion matrix, the empirical false-positive rate, and the
+// timings. Every *sample*-th query is reported individually. The number of
+// keys is null for a loaded filter, in which case the summary omits it.
+trial<nothing> query_summary(config const& cfg, bloom_filter const& bf,
+                             double build_seconds, size_t const* keys) {
+  typedef std::chrono::steady_clock clock_type;
+  auto numeric = cfg.check("numeric");
+  auto sample = *cfg.as<size_t>("sample");
+  auto json = *cfg.as<std::string>("output") == "json";
+  auto query_file = *cfg.as<std::string>("query");
+  std::ifstream query{query_file};
+  if (!query)
+    return error{"cannot read " + query_file};
+  std::vector<size_t> truth;
+  std::vector<std::string> elements;
+  size_t ground_truth;
+  std::string element;
+  while (query >> ground_truth >> element) { // uniq -c
+    truth.push_back(ground_truth);
+    elements.push_back(std::move(element));
+  }
+  std::vector<double> numbers;
+  std::vector<object> objects;
+  if (numeric) {
+    for (auto& e : elements)
+      numbers.push_back(std::strtod(e.c_str(), nullptr));
+    for (auto& x : numbers)
+      objects.push_back(wrap(x));
+  } else {
+    for (auto& e : elements)
+      objects.push_back(wrap(e));
+  }
+  auto start = clock_type::now();
+  auto counts = bf.lookup(objects);
+  std::chrono::duration<double> elapsed = clock_type::now() - start;
+  auto query_seconds = elapsed.count();
+  size_t tn = 0, tp = 0, fp = 0, fn = 0, negatives = 0, false_positives = 0;
+  for (size_t i = 0; i < counts.size(); ++i) {
+    auto count = counts[i];
+    if (count == 0 && truth[i] == 0)
+      ++tn;
+    else if (count == truth[i])
+      ++tp;
+    else if (count > truth[i])
+      ++fp;
+    else
+      ++fn;
+    negatives += truth[i] == 0;
+    false_positives += truth[i] == 0 && count > 0;
+  }
+  auto fp_rate = negatives == 0 ? 0.0
+                                : static_cast<double>(false_positives)
+                                    / negatives;
+  auto bytes = filter_bytes(bf);
+  auto per_key = keys != nullptr && *keys > 0;
+  auto queries_per_s = query_seconds > 0 ? counts.size() / query_seconds : 0.0;
+  auto& out = std::cout;
+  if (json) {
+    out << "{\"tn\": " << tn << ", \"tp\": " << tp << ", \"fp\": " << fp
+        << ", \"fn\": " << fn << ", \"negatives\": " << negatives
+        << ", \"fp_rate\": " << fp_rate << ", \"keys\": ";
+    if (keys)
+      out << *keys;
+    else
+      out << "null";
+    out << ", \"bytes\": " << bytes << ", \"bytes_per_key\": ";
+    if (per_key)
+      out << bytes / *keys;
+    else
+      out << "null";
+    out << ", \"build_s\": " << build_seconds
+        << ", \"query_s\": " << query_seconds << ", \"queries_per_s\": "
+        << queries_per_s;
+    if (sample > 0) {
+      out << ", \"samples\": [";
+      for (size_t i = 0; i < counts.size(); i += sample) {
+        out << (i == 0 ? "" : ", ") << "{\"g\": " << truth[i]
+            << ", \"c\": " << counts[i] << ", \"e\": ";
+        write_json_string(out, elements[i]);
+        out << '}';
+      }
+      out << ']';
+    }
+    out << "}\n";
+  } else {
+    if (sample > 0)
+      for (size_t i = 0; i < counts.size(); i += sample)
+        out << "sample " << truth[i] << ' ' << counts[i] << ' '
+            << elements[i] << '\n';
+    out << "tn " << tn << '\n'
+        << "tp " << tp << '\n'
+        << "fp " << fp << '\n'
+        << "fn " << fn << '\n'
+        << "negatives " << negatives << '\n'
+        << "fp_rate " << fp_rate << '\n';
+    if (keys)
+      out << "keys " << *keys << '\n';
+    out << "bytes " << bytes << '\n';
+    if (per_key)
+      out << "bytes_per_key " << bytes / *keys << '\n';
+    out << "build_s " << build_seconds << '\n'
+        << "query_s " << query_seconds << '\n'
+        << "queries_per_s " << queries_per_s << '\n';
+  }
+  out << std::flush;
+  return nil;
+}
+
+trial<nothing> run(config const& cfg) {
+  auto start = std::chrono::steady_clock::now();
+  std::unique_ptr<bloom_filter> bf;
+  size_t keys = 0;
+  size_t const* known = nullptr; // Loaded filters do not record their keys.
+  if (cfg.check("load")) {
+    auto loaded = load_filter(*cfg.as<std::string>("load"));
+    if (!loaded)
+      return loaded.failure();
+    bf = std::move(*loaded);
+  } else {
+    auto made = make_filter(cfg);
+    if (!made)
+      return made.failure();
+    bf = std::move(*made);
+    auto n = ingest(cfg, *bf);
+    if (!n)
+      return n.failure();
+    keys = *n;
+    known = &keys;
+  }
+  std::chrono::duration<double> build =
+    std::chrono::steady_clock::now() - start;
+  if (cfg.check("save")) {
+    auto t = save_filter(*bf, *cfg.as<std::string>("save"));
+    if (!t)
+      return t;
   }
+  if (cfg.check("serve"))
+    return serve(*bf, *cfg.as<std::string>("serve"));
+  if (!cfg.check("query"))
+    return nil;
+  if (*cfg.as<std::string>("output") == "log")
+    return query_log(cfg, *bf);
+  return query_summary(cfg, *bf, build.count(), known);
+}
 
+trial<nothing> connect(config const& cfg) {
+  // Look up the elements of the query file, or random 8-byte keys.
+  std::vector<std::string> keys;
+  if (cfg.check("query")) {
+    auto query_file = *cfg.as<std::string>("query");
+    std::ifstream query{query_file};
+    if (!query)
+      return error{"cannot read " + query_file};
+    size_t ground_truth;
+    std::string element;
+    while (query >> ground_truth >> element)
+      keys.push_back(element);
+  } else {
+    std::mt19937_64 prng(*cfg.as<size_t>("seed"));
+    for (size_t i = 0; i < 100000; ++i) {
+      auto x = prng();
+      keys.emplace_back(reinterpret_cast<char const*>(&x), sizeof(x));
+    }
+  }
+  return generate_load(*cfg.as<std::string>("connect"), keys,
+                       *cfg.as<size_t>("requests"),
+                       *cfg.as<size_t>("pipeline"));
+}
+
+trial<candidate> make_candidate(config const& cfg, std::string const& type,
+                                size_t n) {
+  auto fpr = *cfg.as<double>("fp-rate");
+  auto seed = *cfg.as<size_t>("seed");
+  auto width = *cfg.as<size_t>("width");
+  if (fpr == 0)
+    fpr = 0.01;
+  if (n == 0)
+    return error{"need non-zero keys"};
+  auto m = basic_bloom_filter::m(fpr, n);
+  auto k = basic_bloom_filter::k(m, n);
+  // Add all keys to a filter that starts out empty.
+  auto fill = [](bloom_filter* f, std::vector<object> const& keys) {
+    std::unique_ptr<bloom_filter> p{f};
+    for (auto& key : keys)
+      p->add(key);
+    return p;
+  };
+  candidate c;
+  c.name = type;
+  if (type == "basic" || type == "basic-partitioned") {
+    auto part = type == "basic-partitioned";
+    c.build = [=](std::vector<object> const& keys) {
+      auto h = make_hasher(k, seed, true);
+      return fill(new basic_bloom_filter(std::move(h), m, part), keys);
+    };
+    c.bits = [](bloom_filter const& f) {
+      return static_cast<basic_bloom_filter const&>(f).storage().size();
+    };
+  } else if (type == "counting" || type == "spectral-mi"
+             || type == "stable") {
+    // Unless given, use 4-bit counters, and 2-bit cells for stable filters.
+    auto w = cfg.check("width") ? width : type == "stable" ? 2 : 4;
+    c.build = [=](std::vector<object> const& keys) {
+      auto h = make_hasher(k, seed, true);
+      bloom_filter* f;
+      if (type == "counting")
+        f = new counting_bloom_filter(std::move(h), m, w);
+      else if (type == "spectral-mi")
+        f = new spectral_mi_bloom_filter(std::move(h), m, w);
+      else
+        f = new stable_bloom_filter(std::move(h), m, w, 1, seed);
+      return fill(f, keys);
+    };
+    c.bits = [=](bloom_filter const&) { return m * w; };
+  } else if (type == "a2") {
+    // Both halves must hold all keys to avoid false negatives.
+    auto cells = 2 * m;
+    c.build = [=](std::vector<object> const& keys) {
+      return fill(new a2_bloom_filter(k, cells, n, seed, seed + 1), keys);
+    };
+    c.bits = [=](bloom_filter const&) { return cells; };
+  } else if (type == "cuckoo") {
+    c.build = [=](std::vector<object> const& keys) {
+      return fill(new cuckoo_filter(fpr, n, seed), keys);
+    };
+    c.bits = [=](bloom_filter const&) {
+      return cuckoo_filter::buckets(n) * cuckoo_filter::bucket_size
+             * cuckoo_filter::fingerprint_bits(fpr);
+    };
+  } else if (type == "quotient") {
+    c.build = [=](std::vector<object> const& keys) {
+      return fill(new counting_quotient_filter(fpr, n, seed), keys);
+    };
+    c.bits = [](bloom_filter const& f) {
+      auto& q = static_cast<counting_quotient_filter const&>(f);
+      return q.slots() * q.slot_bits();
+    };
+  } else if (type == "fuse") {
+    auto bits = fpr < 1.0 / 256 ? 16 : 8;
+    c.build = [=](std::vector<object> const& keys) {
+      return std::unique_ptr<bloom_filter>{
+        new binary_fuse_filter(keys.begin(), keys.end(), bits, seed)};
+    };
+    c.bits = [](bloom_filter const& f) {
+      auto& x = static_cast<binary_fuse_filter const&>(f);
+      return x.slots() * x.fingerprint_bits();
+    };
+  } else if (type == "ribbon") {
+    auto r = ribbon_filter::fingerprint_bits(fpr);
+    c.build = [=](std::vector<object> const& keys) {
+      return std::unique_ptr<bloom_filter>{
+        new ribbon_filter(keys.begin(), keys.end(), r, 1, seed)};
+    };
+    c.bits = [](bloom_filter const& f) {
+      auto& x = static_cast<ribbon_filter const&>(f);
+      return x.slots() * x.fingerprint_bits();
+    };
+  } else if (type == "scalable") {
+    // Start small to include the cost of growing.
+    auto initial = std::max<size_t>(n / 16, 1);
+    c.build = [=](std::vector<object> const& keys) {
+      return fill(new scalable_bloom_filter(fpr, initial, 2, 0.85, seed),
+                  keys);
+    };
+    c.bits = [=](bloom_filter const& f) {
+      auto slices = static_cast<scalable_bloom_filter const&>(f).slices();
+      size_t bits = 0;
+      auto p = fpr * (1 - 0.85);
+      auto capacity = initial;
+      for (size_t i = 0; i < slices; ++i, p *= 0.85, capacity *= 2)
+        bits += basic_bloom_filter::m(p, capacity);
+      return bits;
+    };
+  } else {
+    return error{"invalid bloom filter type for evaluation: " + type};
+  }
+  return c;
+}
+
+trial<nothing> evaluate(config const& cfg) {
+  workload w;
+  try {
+    w.distribution = parse_distribution(*cfg.as<std::string>("distribution"));
+  } catch (std::invalid_argument const& e) {
+    return error{e.what()};
+  }
+  w.keys = *cfg.as<size_t>("keys");
+  w.queries = *cfg.as<size_t>("queries");
+  w.skew = *cfg.as<double>("skew");
+  w.min_length = *cfg.as<size_t>("min-length");
+  w.max_length = *cfg.as<size_t>("max-length");
+  w.seed = *cfg.as<size_t>("seed");
+  if (w.min_length == 0 || w.min_length > w.max_length
+      || w.max_length > default_hash_function::max_obj_size)
+    return error{"invalid string length range"};
+  auto format = *cfg.as<std::string>("format");
+  if (format != "csv" && format != "json")
+    return error{"invalid output format"};
+  dataset data{w};
+  std::vector<evaluation> results;
+  auto types = *cfg.as<std::vector<std::string>>("types");
+  for (auto& type : types) {
+    auto c = make_candidate(cfg, type, data.keys().size());
+    if (!c)
+      return c.failure();
+    results.push_back(bf::evaluate(*c, data));
+  }
+  if (format == "json")
+    write_json(std::cout, results);
+  else
+    write_csv(std::cout, results);
   return nil;
 }
 
@@ -194,21 +690,76 @@ int main(int argc, char* argv[]) {
     return 0;
   }
 
-  if (!cfg->check("type")) {
+  if (cfg->check("connect")) {
+    auto t = connect(*cfg);
+    if (!t) {
+      std::cerr << t.failure().msg() << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (cfg->check("evaluate")) {
+    auto t = evaluate(*cfg);
+    if (!t) {
+      std::cerr << t.failure().msg() << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  if (cfg->check("load")) {
+    // A loaded filter has its own type and shape, so the options to build
+    // one would have no effect.
+    auto build_options = {"input", "type", "fp-rate", "capacity", "cells",
+                          "width", "partition", "evict", "hash-functions",
+                          "double-hashing", "seed", "cells-2nd", "width-2nd",
+                          "hash-functions-2nd", "double-hashing-2nd",
+                          "seed-2nd"};
+    for (auto opt : build_options)
+      if (cfg->check(opt)) {
+        std::cerr << "--" << opt << " cannot be combined with --load"
+                  << std::endl;
+        return 1;
+      }
+  }
+
+  if (cfg->check("query-only")) {
+    // A one-shot query run: answer a query file from a saved filter, without
+    // building, saving, or serving.
+    if (!cfg->check("load") || !cfg->check("query")) {
+      std::cerr << "--query-only requires --load and --query" << std::endl;
+      return 1;
+    }
+    for (auto opt : {"save", "serve"})
+      if (cfg->check(opt)) {
+        std::cerr << "--" << opt << " cannot be combined with --query-only"
+                  << std::endl;
+        return 1;
+      }
+  }
+
+  if (!cfg->check("type") && !cfg->check("load")) {
     std::cerr << "missing bloom filter type" << std::endl;
     return 1;
   }
 
-  if (!cfg->check("input")) {
+  if (!cfg->check("input") && !cfg->check("load")) {
     std::cerr << "missing input file" << std::endl;
     return 1;
   }
 
-  if (!cfg->check("query")) {
+  if (!cfg->check("query") && !cfg->check("serve") && !cfg->check("save")) {
     std::cerr << "missing query file" << std::endl;
     return 1;
   }
 
+  auto output = *cfg->as<std::string>("output");
+  if (output != "log" && output != "summary" && output != "json") {
+    std::cerr << "invalid output mode" << std::endl;
+    return 1;
+  }
+
   auto t = run(*cfg);
   if (!t) {
     std::cerr << t.failure().msg() << std::endl;
@@ -1,6 +1,8 @@
 #include "configuration.h"
 
+#include <algorithm>
 #include <sstream>
+#include <thread>
 
 std::string config::banner() const {
   std::stringstream ss;
@@ -17,8 +19,16 @@ void config::initialize() {
   auto& general = create_block("general options");
   general.add('i', "input", "input file").single();
   general.add('q', "query", "query file").single();
+  general.add('l', "load", "load a serialized filter instead of building")
+    .single();
+  general.add("save", "serialize the filter to a file").single();
+  general.add("query-only", "answer --query from a --load filter and exit");
+  general.add("output", "log|summary|json").init("log");
+  general.add("sample", "report every Nth query in summary output").init(0);
   general.add('h', "help", "display this help");
   general.add('n', "numeric", "interpret input as numeric values");
+  general.add("threads", "number of threads to ingest input")
+    .init(std::max(std::thread::hardware_concurrency(), 1u));
 
   auto& bloomfilter = create_block("bloom filter options");
   bloomfilter
@@ -40,4 +50,24 @@ void config::initialize() {
   second.add('K', "hash-functions-2nd", "number of hash functions").init(0);
   second.add('D', "double-hashing-2nd", "use double-hashing");
   second.add('S', "seed-2nd", "specify a custom seed").init(0);
+
+  auto& evaluation = create_block("evaluation options");
+  evaluation.add('E', "evaluate", "evaluate filter types on synthetic keys");
+  evaluation.add("types", "filter types to evaluate")
+    .init("basic", "basic-partitioned", "counting", "a2", "cuckoo",
+          "quotient", "fuse", "ribbon", "scalable");
+  evaluation.add("distribution", "uniform|zipf|sequential|strings")
+    .init("uniform");
+  evaluation.add("keys", "number of keys to insert").init(100000);
+  evaluation.add("queries", "number of queries").init(100000);
+  evaluation.add("skew", "Zipf exponent").init(1.0);
+  evaluation.add("min-length", "minimum string length").init(8);
+  evaluation.add("max-length", "maximum string length").init(32);
+  evaluation.add("format", "csv|json").init("csv");
+
+  auto& service = create_block("service options");
+  service.add("serve", "serve lookups on a Unix domain socket").single();
+  service.add("connect", "send lookups to a Unix domain socket").single();
+  service.add("requests", "number of lookups to send").init(1000000);
+  service.add("pipeline", "max number of lookups in flight").init(64);
 }
@@ -0,0 +1,316 @@
+#include "service.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace util;
+
+namespace {
+
+typedef std::chrono::steady_clock clock_type;
+
+// Keys beyond this size indicate a broken client.
+uint32_t const max_key_size = 1 << 20;
+
+volatile std::sig_atomic_t stop = 0;
+
+void handle_signal(int) {
+  stop = 1;
+}
+
+trial<sockaddr_un> make_address(std::string const& path) {
+  sockaddr_un addr;
+  std::memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  if (path.size() >= sizeof(addr.sun_path))
+    return error{"socket path too long: " + path};
+  std::strcpy(addr.sun_path, path.c_str());
+  return addr;
+}
+
+struct connection {
+  explicit connection(int fd) : fd(fd) {
+  }
+
+  int fd;
+  std::vector<char> in;  // Received bytes not yet parsed into requests.
+  std::vector<char> out; // Responses not yet sent.
+  size_t sent = 0;       // The number of bytes of *out* already sent.
+  bool closed = false;   // Whether the client has shut down its end.
+};
+
+// Closes all sockets and removes the socket file on every exit path.
+struct cleanup {
+  ~cleanup() {
+    for (auto& c : clients)
+      ::close(c.fd);
+    ::close(listener);
+    ::unlink(path.c_str());
+  }
+
+  std::vector<connection>& clients;
+  int listener;
+  std::string const& path;
+};
+
+// Reads all available bytes. Returns false on EOF or error.
+bool receive(connection& c) {
+  char buf[65536];
+  for (;;) {
+    auto n = ::read(c.fd, buf, sizeof(buf));
+    if (n > 0)
+      c.in.insert(c.in.end(), buf, buf + n);
+    else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return true;
+    else if (n < 0 && errno == EINTR)
+      continue;
+    else
+      return false;
+  }
+}
+
+// Sends pending responses. Returns false on error.
+bool transmit(connection& c) {
+  while (c.sent < c.out.size()) {
+    auto n = ::write(c.fd, c.out.data() + c.sent, c.out.size() - c.sent);
+    if (n > 0)
+      c.sent += n;
+    else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+      return true;
+    else if (n < 0 && errno == EINTR)
+      continue;
+    else
+      return false;
+  }
+  c.out.clear();
+  c.sent = 0;
+  return true;
+}
+
+// Writes a buffer completely to a blocking socket.
+bool write_all(int fd, char const* data, size_t size) {
+  while (size > 0) {
+    auto n = ::write(fd, data, size);
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0)
+      return false;
+    data += n;
+    size -= n;
+  }
+  return true;
+}
+
+} // namespace <anonymous>
+
+trial<nothing> serve(bf::bloom_filter const& bf, std::string const& path) {
+  auto addr = make_address(path);
+  if (!addr)
+    return addr.failure();
+  auto listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0)
+    return error{"cannot create socket"};
+  ::unlink(path.c_str());
+  auto sa = reinterpret_cast<sockaddr*>(&*addr);
+  if (::bind(listener, sa, sizeof(*addr)) != 0
+      || ::listen(listener, SOMAXCONN) != 0) {
+    ::close(listener);
+    return error{"cannot listen on " + path};
+  }
+  ::fcntl(listener, F_SETFL, O_NONBLOCK);
+  std::signal(SIGINT, handle_signal);
+  std::signal(SIGTERM, handle_signal);
+  std::signal(SIGPIPE, SIG_IGN);
+  std::vector<connection> clients;
+  cleanup guard{clients, listener, path};
+  std::vector<pollfd> fds;
+  std::vector<bf::object> batch;
+  std::vector<size_t> owners; // The client of each request in the batch.
+  while (!stop) {
+    fds.clear();
+    fds.push_back({listener, POLLIN, 0});
+    for (auto& c : clients) {
+      short events = c.closed ? 0 : POLLIN;
+      if (!c.out.empty())
+        events |= POLLOUT;
+      fds.push_back({c.fd, events, 0});
+    }
+    if (::poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      break;
+    }
+    // Gather the complete requests of all clients.
+    batch.clear();
+    owners.clear();
+    std::vector<size_t> consumed(clients.size(), 0);
+    for (size_t i = 0; i < clients.size(); ++i) {
+      auto& c = clients[i];
+      if (fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR))
+        if (!c.closed && !receive(c))
+          c.closed = true;
+      auto& pos = consumed[i];
+      while (c.in.size() - pos >= sizeof(uint32_t)) {
+        uint32_t size;
+        std::memcpy(&size, c.in.data() + pos, sizeof(size));
+        if (size > max_key_size) {
+          c.closed = true;
+          c.in.clear();
+          pos = 0;
+          break;
+        }
+        if (c.in.size() - pos - sizeof(size) < size)
+          break;
+        batch.emplace_back(c.in.data() + pos + sizeof(size), size);
+        owners.push_back(i);
+        pos += sizeof(size) + size;
+      }
+    }
+    if (!batch.empty()) {
+      // A key the filter rejects, e.g., one too large to hash, fails the
+      // whole batch. Then look up each key on its own and drop only the
+      // clients that sent an invalid key.
+      std::vector<size_t> results;
+      std::vector<bool> failed(clients.size(), false);
+      try {
+        results = bf.lookup(batch);
+      } catch (std::exception const&) {
+        results.resize(batch.size());
+        for (size_t j = 0; j < batch.size(); ++j)
+          try {
+            results[j] = bf.lookup(batch[j]);
+          } catch (std::exception const&) {
+            failed[owners[j]] = true;
+          }
+      }
+      for (size_t j = 0; j < results.size(); ++j) {
+        if (failed[owners[j]])
+          continue;
+        uint64_t r = results[j];
+        auto p = reinterpret_cast<char const*>(&r);
+        auto& out = clients[owners[j]].out;
+        out.insert(out.end(), p, p + sizeof(r));
+      }
+      for (size_t i = 0; i < clients.size(); ++i)
+        if (failed[i]) {
+          clients[i].closed = true;
+          clients[i].out.clear();
+        }
+    }
+    for (size_t i = 0; i < clients.size(); ++i) {
+      auto& c = clients[i];
+      c.in.erase(c.in.begin(), c.in.begin() + consumed[i]);
+      if (!transmit(c)) {
+        c.closed = true;
+        c.out.clear();
+      }
+    }
+    // Drop clients that have shut down and received all responses.
+    auto done = [](connection const& c) {
+      if (c.closed && c.out.empty()) {
+        ::close(c.fd);
+        return true;
+      }
+      return false;
+    };
+    clients.erase(std::remove_if(clients.begin(), clients.end(), done),
+                  clients.end());
+    // Accept last so that fds covers every client gathered above; new
+    // clients join the poll set in the next iteration.
+    if (fds[0].revents & POLLIN)
+      for (int fd; (fd = ::accept(listener, nullptr, nullptr)) >= 0;) {
+        ::fcntl(fd, F_SETFL, O_NONBLOCK);
+        clients.emplace_back(fd);
+      }
+  }
+  return nil;
+}
+
+trial<nothing> generate_load(std::string const& path,
+                             std::vector<std::string> const& keys,
+                             size_t requests, size_t pipeline) {
+  if (keys.empty())
+    return error{"no keys to look up"};
+  if (pipeline == 0)
+    return error{"need a non-zero pipeline depth"};
+  auto addr = make_address(path);
+  if (!addr)
+    return addr.failure();
+  auto fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0)
+    return error{"cannot create socket"};
+  auto sa = reinterpret_cast<sockaddr*>(&*addr);
+  if (::connect(fd, sa, sizeof(*addr)) != 0) {
+    ::close(fd);
+    return error{"cannot connect to " + path};
+  }
+  std::vector<clock_type::time_point> sent_at(requests);
+  std::vector<double> latencies(requests);
+  std::vector<char> out;
+  std::vector<char> in;
+  size_t sent = 0;
+  size_t received = 0;
+  size_t hits = 0;
+  auto start = clock_type::now();
+  while (received < requests) {
+    out.clear();
+    auto now = clock_type::now();
+    for (; sent < requests && sent - received < pipeline; ++sent) {
+      auto& key = keys[sent % keys.size()];
+      uint32_t size = key.size();
+      auto p = reinterpret_cast<char const*>(&size);
+      out.insert(out.end(), p, p + sizeof(size));
+      out.insert(out.end(), key.begin(), key.end());
+      sent_at[sent] = now;
+    }
+    if (!write_all(fd, out.data(), out.size())) {
+      ::close(fd);
+      return error{"connection lost"};
+    }
+    char buf[65536];
+    auto n = ::read(fd, buf, sizeof(buf));
+    if (n < 0 && errno == EINTR)
+      continue;
+    if (n <= 0) {
+      ::close(fd);
+      return error{"connection lost"};
+    }
+    in.insert(in.end(), buf, buf + n);
+    now = clock_type::now();
+    size_t pos = 0;
+    for (; in.size() - pos >= sizeof(uint64_t); pos += sizeof(uint64_t)) {
+      uint64_t r;
+      std::memcpy(&r, in.data() + pos, sizeof(r));
+      hits += r != 0;
+      std::chrono::duration<double, std::micro> d = now - sent_at[received];
+      latencies[received++] = d.count();
+    }
+    in.erase(in.begin(), in.begin() + pos);
+  }
+  std::chrono::duration<double> elapsed = clock_type::now() - start;
+  ::close(fd);
+  std::sort(latencies.begin(), latencies.end());
+  auto percentile = [&](double p) {
+    return requests == 0 ? 0 : latencies[std::min<size_t>(
+                                 requests * p, requests - 1)];
+  };
+  std::cout << "requests " << requests << '\n'
+            << "hits " << hits << '\n'
+            << "seconds " << elapsed.count() << '\n'
+            << "requests_per_s " << requests / elapsed.count() << '\n'
+            << "p50_us " << percentile(0.5) << '\n'
+            << "p99_us " << percentile(0.99) << std::endl;
+  return nil;
+}
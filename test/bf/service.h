@@ -0,0 +1,37 @@
+#ifndef SERVICE_H
+#define SERVICE_H
+
+#include <string>
+#include <vector>
+
+#include "util/trial.h"
+
+#include "bf/bloom_filter.hpp"
+
+// The query service speaks a pipelined binary protocol over a Unix domain
+// socket. A request consists of the key length as 32-bit integer followed by
+// the key bytes, and a response of the lookup result as 64-bit integer, both
+// in host byte order. Clients may send any number of requests without
+// waiting, and receive the responses in request order. A client that sends a
+// key the filter cannot look up, e.g., one longer than the hash function
+// accepts, is disconnected.
+
+/// Serves lookups until the process receives SIGINT or SIGTERM. Each
+/// iteration of the event loop gathers the complete requests of all clients
+/// into a single batch lookup.
+/// @param bf The filter to query.
+/// @param path The path of the socket.
+util::trial<util::nothing> serve(bf::bloom_filter const& bf,
+                                 std::string const& path);
+
+/// Sends lookups to a service and prints the throughput and the p50 and p99
+/// latency.
+/// @param path The path of the socket.
+/// @param keys The keys to look up, cycled through until *requests* are sent.
+/// @param requests The number of requests to send.
+/// @param pipeline The maximum number of requests in flight.
+util::trial<util::nothing> generate_load(std::string const& path,
+                                         std::vector<std::string> const& keys,
+                                         size_t requests, size_t pipeline);
+
+#endif
@@ -1,6 +1,13 @@
 #include "test.hpp"
 
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
 #include "bf/all.hpp"
+#include "bf/bulk.hpp"
 
 using namespace bf;
 
@@ -144,6 +151,34 @@ TEST(counter_vector_mergin) {
   CHECK_EQUAL(to_string(a | b), "1001111100");
 }
 
+TEST(counter_vector_range) {
+  for (size_t width : {1, 2, 3, 4, 8, 64}) {
+    counter_vector v(200, width);
+    for (size_t i = 0; i < 200; ++i)
+      v.set(i, i % 3 == 0 ? 0 : std::min<size_t>(i % 5, v.max()));
+    std::vector<size_t> expected(200);
+    for (size_t i = 0; i < 200; ++i)
+      expected[i] = v.count(i);
+    auto ones = 0u;
+    for (size_t i = 10; i < 150; ++i)
+      ones += expected[i] == 1;
+    CHECK_EQUAL(v.count_equal(10, 150, 1), ones);
+    v.decrement_range(10, 150);
+    size_t mismatches = 0;
+    for (size_t i = 0; i < 200; ++i) {
+      auto e = expected[i];
+      if (i >= 10 && i < 150 && e > 0)
+        --e;
+      mismatches += v.count(i) != e;
+    }
+    CHECK_EQUAL(mismatches, 0u);
+  }
+  counter_vector v(4, 3);
+  v.set(0, 2);
+  CHECK(!v.decrement(0, 3));
+  CHECK_EQUAL(v.count(0), 0u);
+}
+
 TEST(bloom_filter_basic) {
   basic_bloom_filter bf(0.8, 10);
   bf.add("foo");
@@ -322,3 +357,947 @@ TEST(bloom_filter_a2) {
   CHECK_EQUAL(bf.lookup("baz"), 1u);
   CHECK_EQUAL(bf.lookup("qux"), 1u);
 }
+
+TEST(bloom_filter_cuckoo) {
+  cuckoo_filter bf(0.01, 100);
+  CHECK_EQUAL(bf.lookup("foo"), 0u);
+  bf.add("foo");
+  bf.add("bar");
+  bf.add(42);
+  CHECK_EQUAL(bf.lookup("foo"), 1u);
+  CHECK_EQUAL(bf.lookup("bar"), 1u);
+  CHECK_EQUAL(bf.lookup(42), 1u);
+  // Duplicates occupy separate slots.
+  bf.add("foo");
+  CHECK_EQUAL(bf.lookup("foo"), 2u);
+  CHECK(bf.remove("foo"));
+  CHECK_EQUAL(bf.lookup("foo"), 1u);
+  CHECK(bf.remove("foo"));
+  CHECK_EQUAL(bf.lookup("foo"), 0u);
+  CHECK(!bf.remove("foo"));
+  CHECK_EQUAL(bf.lookup("bar"), 1u);
+  CHECK_EQUAL(bf.size(), 2u);
+  // Fill up to capacity without false negatives.
+  cuckoo_filter full(default_hash_function(0), 32, 12);
+  for (size_t i = 0; i < 120; ++i)
+    full.add(i);
+  size_t fn = 0;
+  for (size_t i = 0; i < 120; ++i)
+    if (full.lookup(i) == 0)
+      ++fn;
+  CHECK_EQUAL(fn, 0u);
+  for (size_t i = 0; i < 120; ++i)
+    full.remove(i);
+  CHECK_EQUAL(full.size(), 0u);
+}
+
+TEST(bloom_filter_counting_quotient) {
+  counting_quotient_filter bf(default_hash_function(0), 4, 8);
+  bf.add("foo");
+  bf.add("bar", 3);
+  bf.add("foo");
+  CHECK_EQUAL(bf.lookup("foo"), 2u);
+  CHECK_EQUAL(bf.lookup("bar"), 3u);
+  CHECK_EQUAL(bf.lookup("baz"), 0u);
+  // Large counts span multiple counter slots.
+  bf.add("baz", 100000);
+  CHECK_EQUAL(bf.lookup("baz"), 100000u);
+  CHECK(bf.remove("baz", 99999));
+  CHECK_EQUAL(bf.lookup("baz"), 1u);
+  CHECK(bf.remove("baz"));
+  CHECK_EQUAL(bf.lookup("baz"), 0u);
+  CHECK(!bf.remove("qux"));
+  // Exceeding the load factor doubles the table.
+  for (size_t i = 0; i < 100; ++i)
+    bf.add(i, i + 1);
+  CHECK(bf.quotient_bits() > 4);
+  CHECK_EQUAL(bf.quotient_bits() + bf.remainder_bits(), 12u);
+  CHECK_EQUAL(bf.slot_bits(), bf.remainder_bits() + 4);
+  size_t fn = 0;
+  for (size_t i = 0; i < 100; ++i)
+    if (bf.lookup(i) < i + 1)
+      ++fn;
+  CHECK_EQUAL(fn, 0u);
+  CHECK_EQUAL(bf.lookup("foo"), 2u);
+  // Merging adds up counts.
+  counting_quotient_filter other(default_hash_function(0), 6, 6);
+  other.add("foo", 5);
+  other.add("corge");
+  bf.merge(other);
+  CHECK_EQUAL(bf.lookup("foo"), 7u);
+  CHECK_EQUAL(bf.lookup("corge"), 1u);
+  CHECK_EQUAL(bf.lookup("bar"), 3u);
+  bf.clear();
+  CHECK_EQUAL(bf.lookup("foo"), 0u);
+  CHECK_EQUAL(bf.size(), 0u);
+  // Once the remainders are down to one bit, the table cannot grow anymore.
+  counting_quotient_filter small(0.01, 100);
+  auto capacity = small.quotient_bits() + small.remainder_bits();
+  auto full = false;
+  size_t added = 0;
+  try {
+    for (; added < 100000; ++added)
+      small.add(added);
+  } catch (std::length_error const&) {
+    full = true;
+  }
+  CHECK(full);
+  CHECK_EQUAL(small.remainder_bits(), 1u);
+  CHECK_EQUAL(small.quotient_bits() + small.remainder_bits(), capacity);
+  size_t missing = 0;
+  for (size_t i = 0; i < added; ++i)
+    if (small.lookup(i) == 0)
+      ++missing;
+  CHECK_EQUAL(missing, 0u);
+}
+
+TEST(bloom_filter_binary_fuse) {
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 10000; ++i)
+    keys.push_back(i * 7919);
+  binary_fuse_filter bf(keys.begin(), keys.end());
+  CHECK_EQUAL(bf.size(), keys.size());
+  CHECK(bf.slots() < keys.size() * 1.3);
+  size_t fn = 0;
+  for (auto k : keys)
+    if (bf.lookup(k) == 0)
+      ++fn;
+  CHECK_EQUAL(fn, 0u);
+  size_t fp = 0;
+  for (uint64_t i = 0; i < 10000; ++i)
+    fp += bf.lookup(i * 7919 + 1);
+  CHECK(fp < 100);
+  auto added = false;
+  try {
+    bf.add(42);
+  } catch (std::logic_error const&) {
+    added = true;
+  }
+  CHECK(added);
+  // Round-trip through a stream.
+  std::stringstream ss;
+  bf.save(ss);
+  auto loaded = binary_fuse_filter::load(ss);
+  CHECK_EQUAL(loaded.size(), bf.size());
+  CHECK_EQUAL(loaded.lookup(keys[42]), 1u);
+  CHECK_EQUAL(loaded.lookup(uint64_t{1}), bf.lookup(uint64_t{1}));
+  // Round-trip through a memory-mapped file.
+  auto filename = "bf-test-fuse.bin";
+  {
+    std::ofstream out{filename, std::ios::binary};
+    bf.save(out);
+  }
+  auto mapped = binary_fuse_filter::load(std::string{filename});
+  std::remove(filename);
+  CHECK_EQUAL(mapped.lookup(keys[4711]), 1u);
+  CHECK_EQUAL(mapped.slots(), bf.slots());
+  // 16-bit fingerprints from strings.
+  std::vector<std::string> strs{"foo", "bar", "baz"};
+  binary_fuse_filter bf16(strs.begin(), strs.end(), 16);
+  CHECK_EQUAL(bf16.lookup(strs[0]), 1u);
+  CHECK_EQUAL(bf16.lookup(strs[1]), 1u);
+  CHECK_EQUAL(bf16.lookup(strs[2]), 1u);
+  CHECK_EQUAL(bf16.lookup(std::string{"qux"}), 0u);
+  bf16.clear();
+  CHECK_EQUAL(bf16.lookup(strs[0]), 0u);
+}
+
+TEST(bloom_filter_ribbon) {
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 600000; ++i)
+    keys.push_back(2 * i);
+  ribbon_filter bf(keys.begin(), keys.end(), 8, 4);
+  CHECK_EQUAL(bf.size(), keys.size());
+  CHECK_EQUAL(bf.partitions(), 3u);
+  CHECK(bf.slots() * bf.fingerprint_bits()
+        < keys.size() * ribbon_filter::bits_per_key(8) + 3 * 64 * 8);
+  size_t fn = 0;
+  for (auto k : keys)
+    if (bf.lookup(k) == 0)
+      ++fn;
+  CHECK_EQUAL(fn, 0u);
+  size_t fp = 0;
+  for (uint64_t i = 0; i < 100000; ++i)
+    fp += bf.lookup(2 * i + 1);
+  CHECK(fp < 600); // Expected: 100000 / 256 = 390.
+  // The partitioning does not depend on the number of threads.
+  ribbon_filter serial(keys.begin(), keys.begin() + 1000, 8);
+  CHECK_EQUAL(serial.lookup(keys[999]), 1u);
+  CHECK_EQUAL(serial.lookup(keys[1000]), 0u);
+  auto added = false;
+  try {
+    serial.add(42);
+  } catch (std::logic_error const&) {
+    added = true;
+  }
+  CHECK(added);
+}
+
+TEST(bloom_filter_scalable) {
+  scalable_bloom_filter bf(0.01, 100);
+  for (uint64_t i = 0; i < 20000; ++i)
+    bf.add(2 * i);
+  // Elements that appear to exist already are not added again.
+  auto n = bf.size();
+  CHECK(n <= 20000 && n > 19500);
+  CHECK(bf.slices() > 5);
+  size_t fn = 0;
+  for (uint64_t i = 0; i < 20000; ++i)
+    if (bf.lookup(2 * i) == 0)
+      ++fn;
+  CHECK_EQUAL(fn, 0u);
+  size_t fp = 0;
+  for (uint64_t i = 0; i < 100000; ++i)
+    fp += bf.lookup(2 * i + 1);
+  CHECK(fp < 1000);
+  bf.add(uint64_t{0});
+  CHECK_EQUAL(bf.size(), n);
+  std::vector<object> batch;
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 0; i < 1000; ++i)
+    keys.push_back(i);
+  for (auto& k : keys)
+    batch.push_back(wrap(k));
+  auto results = bf.lookup(batch);
+  for (size_t i = 0; i < keys.size(); ++i)
+    CHECK_EQUAL(results[i], bf.lookup(keys[i]));
+  bf.clear();
+  CHECK_EQUAL(bf.slices(), 1u);
+  CHECK_EQUAL(bf.lookup(uint64_t{0}), 0u);
+}
+
+TEST(bloom_filter_count_min) {
+  auto w = count_min_sketch::width(0.001);
+  auto d = count_min_sketch::depth(0.01);
+  CHECK_EQUAL(w, 2719u);
+  CHECK_EQUAL(d, 5u);
+  count_min_sketch cms(w, d);
+  cms.track(3);
+  // A Zipf-like stream: element i occurs 1000 / i times.
+  std::vector<object> batch;
+  std::vector<uint64_t> keys;
+  for (uint64_t i = 1; i <= 1000; ++i)
+    keys.push_back(i);
+  for (auto& k : keys)
+    for (uint64_t j = 0; j < 1000 / k; ++j)
+      batch.push_back(wrap(k));
+  cms.add(batch);
+  CHECK_EQUAL(cms.total(), batch.size());
+  size_t within = 0;
+  for (auto k : keys) {
+    auto estimate = cms.lookup(k);
+    CHECK(estimate >= 1000 / k);
+    within += estimate <= 1000 / k + 0.001 * cms.total();
+  }
+  CHECK(within >= 990);
+  auto top = cms.heavy_hitters();
+  CHECK_EQUAL(top.size(), 3u);
+  uint64_t first;
+  std::memcpy(&first, top[0].first.data(), sizeof(first));
+  CHECK_EQUAL(first, 1u);
+  CHECK_EQUAL(top[0].second, 1000u);
+  // Merging doubles all counts.
+  count_min_sketch other(w, d);
+  other.add(batch);
+  cms.merge(other);
+  CHECK_EQUAL(cms.lookup(uint64_t{1}), 2000u);
+  CHECK_EQUAL(cms.heavy_hitters()[0].second, 2000u);
+  // Counters saturate.
+  count_min_sketch small(16, 2, 4);
+  small.add("foo", 10);
+  small.add("foo", 10);
+  CHECK_EQUAL(small.lookup("foo"), 15u);
+  count_mean_min_sketch cmm(64, 5);
+  for (uint64_t i = 0; i < 10000; ++i)
+    cmm.add(i);
+  cmm.add("foo", 500);
+  auto estimate = cmm.lookup("foo");
+  CHECK(estimate > 450 && estimate <= 660);
+  CHECK(cmm.lookup("bar") < 100);
+}
+
+TEST(bloom_filter_cardinality) {
+  basic_bloom_filter x(0.01, 10000);
+  basic_bloom_filter y(0.01, 10000);
+  CHECK_EQUAL(x.estimated_cardinality(), 0.0);
+  for (uint64_t i = 0; i < 6000; ++i)
+    x.add(i);
+  for (uint64_t i = 4000; i < 10000; ++i)
+    y.add(i);
+  auto n = x.estimated_cardinality();
+  CHECK(n > 5800 && n < 6200);
+  auto u = x.estimated_union(y);
+  CHECK(u > 9700 && u < 10300);
+  auto i = x.estimated_intersection(y);
+  CHECK(i > 1700 && i < 2300);
+  CHECK_EQUAL(x.estimated_union(x), n);
+  // Filters of different sizes or hashers cannot be compared.
+  basic_bloom_filter z(0.01, 20000);
+  auto incompatible = [&](basic_bloom_filter const& other) {
+    size_t rejected = 0;
+    try {
+      x.estimated_union(other);
+    } catch (std::invalid_argument const&) {
+      ++rejected;
+    }
+    try {
+      x.estimated_intersection(other);
+    } catch (std::invalid_argument const&) {
+      ++rejected;
+    }
+    return rejected == 2;
+  };
+  CHECK(incompatible(z));
+  basic_bloom_filter seeded(make_hasher(7, 42), x.storage().size());
+  CHECK(incompatible(seeded));
+  bitvector a(130), b(130);
+  a.set(0);
+  a.set(64);
+  a.set(129);
+  b.set(64);
+  b.set(100);
+  CHECK_EQUAL(a.count(), 3u);
+  size_t ca, cb, cab;
+  count_joint(a, b, ca, cb, cab);
+  CHECK_EQUAL(ca, 3u);
+  CHECK_EQUAL(cb, 2u);
+  CHECK_EQUAL(cab, 1u);
+}
+
+TEST(bloom_filter_metrics) {
+  basic_bloom_filter bf(0.01, 1000);
+  for (uint64_t i = 0; i < 1000; ++i)
+    bf.add(i);
+  for (uint64_t i = 0; i < 500; ++i)
+    bf.lookup(i);
+  auto m = bf.metrics();
+  CHECK_EQUAL(m.nonzero, bf.storage().count());
+  CHECK_EQUAL(m.adds, 1000u);
+  CHECK_EQUAL(m.lookups, 500u);
+  CHECK(m.fill_ratio() > 0.45 && m.fill_ratio() < 0.55);
+  CHECK(m.fp_rate() > 0.005 && m.fp_rate() < 0.015);
+  bf.clear();
+  CHECK_EQUAL(bf.metrics().nonzero, 0u);
+  counting_bloom_filter cbf(make_hasher(3), 64, 2);
+  for (size_t i = 0; i < 4; ++i)
+    cbf.add("foo");
+  auto cm = cbf.metrics();
+  CHECK_EQUAL(cm.hash_functions, 3u);
+  CHECK_EQUAL(cm.nonzero, 3u);
+  CHECK_EQUAL(cm.saturated, 3u);
+  CHECK_EQUAL(cm.overflows, 3u);
+  for (size_t i = 0; i < 4; ++i)
+    cbf.remove("foo");
+  CHECK_EQUAL(cbf.metrics().underflows, 3u);
+  CHECK_EQUAL(cbf.metrics().removes, 4u);
+  cm = cbf.metrics();
+  CHECK_EQUAL(cm.nonzero, 0u);
+  CHECK_EQUAL(cm.saturated, 0u);
+  // Every thread records into its own slot.
+  basic_bloom_filter shared(0.01, 1000);
+  run_threads(4, [&](size_t t) {
+    for (uint64_t i = 0; i < 1000; ++i)
+      shared.lookup(i * 4 + t);
+  });
+  CHECK_EQUAL(shared.metrics().lookups, 4000u);
+  // Stable filters saturate cells on purpose, which is no overflow.
+  stable_bloom_filter sbf(make_hasher(3), 1024, 2, 1);
+  for (uint64_t i = 0; i < 100; ++i)
+    sbf.add(uint64_t{42});
+  CHECK_EQUAL(sbf.metrics().overflows, 0u);
+  CHECK_EQUAL(sbf.lookup(uint64_t{42}), 3u);
+}
+
+TEST(bloom_filter_age_partitioned) {
+  age_partitioned_bloom_filter bf(0.01, 1000);
+  CHECK(bf.window() >= 1000);
+  CHECK(age_partitioned_bloom_filter::fp_rate(bf.k(), bf.l(), bf.cells(),
+                                              bf.generation()) <= 0.01);
+  size_t fn = 0;
+  size_t fp = 0;
+  for (uint64_t i = 0; i < 20000; ++i) {
+    bf.add(i);
+    // No false negatives within the window.
+    auto first = i < 1000 ? 0 : i - 999;
+    for (auto j = first; j <= i; j += 37)
+      fn += bf.lookup(j) == 0;
+    fp += bf.lookup(i + 1000000);
+  }
+  CHECK_EQUAL(fn, 0u);
+  CHECK(fp < 300); // Expected: at most 20000 * 0.01 = 200.
+  // Elements are forgotten after (k + l) generations.
+  CHECK_EQUAL(bf.lookup(uint64_t{0}), 0u);
+  auto rotations = bf.k() + bf.l();
+  for (size_t i = 0; i < rotations; ++i)
+    bf.rotate();
+  CHECK_EQUAL(bf.lookup(uint64_t{19999}), 0u);
+  bf.add(uint64_t{42});
+  CHECK_EQUAL(bf.lookup(uint64_t{42}), 1u);
+  bf.clear();
+  CHECK_EQUAL(bf.lookup(uint64_t{42}), 0u);
+}
+
+TEST(bloom_filter_expiring) {
+  // A TTL of 10 minutes at a resolution of one minute.
+  auto w = expiring_bloom_filter::width(10);
+  CHECK_EQUAL(w, 5u);
+  expiring_bloom_filter bf(make_hasher(3), 1024, w, 600, 60);
+  CHECK_EQUAL(bf.ttl(), 10u);
+  uint64_t t = 1000000;
+  bf.add("foo", t);
+  CHECK_EQUAL(bf.lookup("foo", t + 599), 1u);
+  CHECK_EQUAL(bf.lookup("foo", t + 660), 0u);
+  // Re-adding refreshes the stamp.
+  bf.add("bar", t + 660);
+  bf.add("bar", t + 1200);
+  CHECK_EQUAL(bf.lookup("bar", t + 1500), 1u);
+  // Stale stamps never reappear as the generation counter wraps.
+  size_t seen = 0;
+  for (uint64_t i = 0; i < 200; ++i)
+    seen += bf.lookup("bar", t + 2000 + 60 * i);
+  CHECK_EQUAL(seen, 0u);
+  // Large jumps expire everything.
+  bf.add("baz", t + 100000);
+  CHECK_EQUAL(bf.lookup("baz", t + 100000), 1u);
+  CHECK_EQUAL(bf.lookup("baz", t + 10000000), 0u);
+  // With a fine resolution, a long idle gap costs at most one pass.
+  expiring_bloom_filter fine(make_hasher(3), 1024, 40, 10, 1);
+  fine.add("foo", 5);
+  CHECK_EQUAL(fine.lookup("foo", 15), 1u);
+  CHECK_EQUAL(fine.lookup("foo", 16), 0u);
+  fine.add("bar", 20);
+  CHECK_EQUAL(fine.lookup("bar", uint64_t{1} << 36), 0u);
+  CHECK_EQUAL(fine.generation(), uint64_t{1} << 36);
+}
+
+TEST(iblt) {
+  // Two replicas share 10000 keys and differ in 60.
+  auto m = iblt::cells(60);
+  iblt x(m), y(m);
+  for (uint64_t i = 0; i < 10000; ++i) {
+    x.insert(i);
+    y.insert(i);
+  }
+  for (uint64_t i = 0; i < 40; ++i)
+    x.insert(1000000 + i);
+  for (uint64_t i = 0; i < 20; ++i)
+    y.insert(2000000 + i);
+  y.erase(uint64_t{7});
+  // Ship y over the wire.
+  std::stringstream wire;
+  y.save(wire);
+  auto remote = iblt::load(wire);
+  CHECK_EQUAL(remote.size(), m);
+  x.subtract(remote);
+  std::vector<uint64_t> only_x, only_y;
+  CHECK(x.list_entries(only_x, only_y));
+  std::sort(only_x.begin(), only_x.end());
+  std::sort(only_y.begin(), only_y.end());
+  CHECK_EQUAL(only_x.size(), 41u);
+  CHECK_EQUAL(only_x[0], 7u);
+  CHECK_EQUAL(only_x[1], 1000000u);
+  CHECK_EQUAL(only_y.size(), 20u);
+  CHECK_EQUAL(only_y[19], 2000019u);
+  // Too many entries for the table.
+  iblt small(iblt::cells(10));
+  for (uint64_t i = 0; i < 1000; ++i)
+    small.insert(i);
+  only_x.clear();
+  CHECK(!small.list_entries(only_x, only_y));
+  small.clear();
+  CHECK(small.list_entries(only_x, only_y));
+}
+
+TEST(bitsliced_index) {
+  std::vector<basic_bloom_filter> filters;
+  for (size_t i = 0; i < 300; ++i) {
+    filters.emplace_back(0.01, 100, 42);
+    for (uint64_t j = 0; j < 100; ++j)
+      filters.back().add(i * 100 + j);
+  }
+  bitsliced_index index(filters[0]);
+  for (auto& f : filters)
+    index.add(f);
+  CHECK_EQUAL(index.size(), 300u);
+  size_t mismatches = 0;
+  for (uint64_t x = 0; x < 40000; x += 7) {
+    auto candidates = index.lookup(x);
+    for (size_t i = 0; i < filters.size(); ++i)
+      mismatches += candidates[i] != (filters[i].lookup(x) == 1);
+  }
+  CHECK_EQUAL(mismatches, 0u);
+  CHECK(index.lookup(uint64_t{4217})[42]);
+  index.add(7, uint64_t{1000000});
+  CHECK(index.lookup(uint64_t{1000000})[7]);
+  basic_bloom_filter other(0.01, 1000);
+  auto rejected = false;
+  try {
+    index.add(other);
+  } catch (std::invalid_argument const&) {
+    rejected = true;
+  }
+  CHECK(rejected);
+}
+
+TEST(static_function) {
+  std::vector<std::pair<std::string, uint64_t>> entries;
+  for (uint64_t i = 0; i < 10000; ++i)
+    entries.emplace_back("key" + std::to_string(i), i % 251);
+  entries.emplace_back("key42", 42 % 251);
+  static_function f(entries.begin(), entries.end());
+  CHECK_EQUAL(f.size(), 10000u);
+  CHECK_EQUAL(f.value_bits(), 8u);
+  CHECK(f.slots() < f.size() * 1.3);
+  size_t errors = 0;
+  for (auto& e : entries)
+    if (f.lookup(e.first) != e.second)
+      ++errors;
+  CHECK_EQUAL(errors, 0u);
+  std::stringstream ss;
+  f.save(ss);
+  auto loaded = static_function::load(ss);
+  CHECK_EQUAL(loaded.lookup("key9999"), 9999u % 251);
+  // Values straddle byte boundaries.
+  std::vector<std::pair<int, uint64_t>> wide{{1, 4095}, {2, 0}, {3, 1234}};
+  static_function g(wide.begin(), wide.end(), 12);
+  CHECK_EQUAL(g.lookup(1), 4095u);
+  CHECK_EQUAL(g.lookup(2), 0u);
+  CHECK_EQUAL(g.lookup(3), 1234u);
+  // Slots are bit-packed rather than rounded up to bytes.
+  std::vector<std::pair<uint64_t, uint64_t>> narrow;
+  for (uint64_t i = 0; i < 10000; ++i)
+    narrow.emplace_back(i, i % 7);
+  static_function t(narrow.begin(), narrow.end(), 3);
+  errors = 0;
+  for (auto& e : narrow)
+    if (t.lookup(e.first) != e.second)
+      ++errors;
+  CHECK_EQUAL(errors, 0u);
+  std::stringstream packed;
+  t.save(packed);
+  auto serialized = packed.str().size();
+  CHECK(serialized < 128 + t.slots() * 3 / 8);
+  auto reloaded = static_function::load(packed);
+  CHECK_EQUAL(reloaded.lookup(uint64_t{9999}), 9999u % 7);
+  // Conflicting values for the same key.
+  wide.emplace_back(2, 1);
+  auto rejected = false;
+  try {
+    static_function h(wide.begin(), wide.end(), 12);
+  } catch (std::invalid_argument const&) {
+    rejected = true;
+  }
+  CHECK(rejected);
+}
+
+TEST(bloom_filter_range) {
+  range_bloom_filter rf(0.01, 1000, 1024);
+  CHECK_EQUAL(rf.levels(), 11u);
+  // Keys at multiples of 1000000, plus one near the top of the key space.
+  for (uint64_t i = 1; i <= 1000; ++i)
+    rf.add(i * 1000000);
+  rf.add(~uint64_t(0));
+  CHECK(rf.lookup(uint64_t{5000000}));
+  CHECK(rf.lookup_range(4999000, 5000000));
+  CHECK(rf.lookup_range(5000000, 5000100));
+  CHECK(rf.lookup_range(4999990, 5000010));
+  CHECK(rf.lookup_range(~uint64_t(0) - 100, ~uint64_t(0)));
+  // Ranges longer than the maximum length still have no false negatives.
+  CHECK(rf.lookup_range(123, 1000000));
+  // Empty ranges between keys.
+  size_t fps = 0;
+  std::vector<range_bloom_filter::range> ranges;
+  for (uint64_t i = 1; i < 1000; ++i) {
+    auto lo = i * 1000000 + 1000 + (i * 7919) % 1000;
+    ranges.emplace_back(lo, lo + 1023);
+    fps += rf.lookup_range(lo, lo + 1023);
+  }
+  CHECK(fps < 30);
+  auto batch = rf.lookup_range(ranges);
+  CHECK_EQUAL(batch.size(), ranges.size());
+  size_t batch_fps = 0;
+  for (auto r : batch)
+    batch_fps += r;
+  CHECK_EQUAL(batch_fps, fps);
+  ranges.emplace_back(2999990, 3000000);
+  CHECK(rf.lookup_range(ranges).back());
+  rf.clear();
+  CHECK(!rf.lookup_range(0, 1 << 20));
+}
+
+TEST(evaluation) {
+  workload w;
+  w.distribution = workload::zipf;
+  w.keys = 1000;
+  w.queries = 5000;
+  dataset data{w};
+  CHECK_EQUAL(data.keys().size(), 1000u);
+  CHECK_EQUAL(data.queries().size(), 5000u);
+  // Popular queries repeat, and some hit the keys.
+  size_t members = 0;
+  for (size_t i = 0; i < data.queries().size(); ++i)
+    members += data.member(i);
+  CHECK(members > 0 && members < 5000);
+  candidate c;
+  c.name = "basic";
+  c.build = [](std::vector<object> const& keys) {
+    std::unique_ptr<bloom_filter> f{new basic_bloom_filter(0.01, 1000)};
+    for (auto& key : keys)
+      f->add(key);
+    return f;
+  };
+  c.bits = [](bloom_filter const& f) {
+    return static_cast<basic_bloom_filter const&>(f).storage().size();
+  };
+  auto e = evaluate(c, data);
+  CHECK_EQUAL(e.false_negatives, 0u);
+  CHECK_EQUAL(e.negatives, 5000 - members);
+  CHECK(e.fp_rate() < 0.05);
+  CHECK(e.bits_per_key > 9 && e.bits_per_key < 10);
+  std::ostringstream csv, json;
+  write_csv(csv, {e});
+  write_json(json, {e});
+  CHECK(csv.str().find("\nbasic,1000,5000,") != std::string::npos);
+  CHECK(json.str().find("\"filter\": \"basic\"") != std::string::npos);
+  w.distribution = workload::sequential;
+  dataset sequential{w};
+  CHECK_EQUAL(*static_cast<uint64_t const*>(sequential.queries()[0].data()),
+              1000u);
+  CHECK(!sequential.member(0));
+  CHECK_EQUAL(parse_distribution("strings"), workload::strings);
+}
+
+TEST(bloom_filter_bulk) {
+  std::vector<uint64_t> keys(100000);
+  for (size_t i = 0; i < keys.size(); ++i)
+    keys[i] = i * 7919;
+  // The bit vector spans several regions.
+  basic_bloom_filter serial(make_hasher(7), 1 << 23);
+  basic_bloom_filter parallel(make_hasher(7), 1 << 23);
+  for (auto k : keys)
+    serial.add(k);
+  parallel.add(keys.begin(), keys.end(), 4);
+  CHECK(serial.storage() == parallel.storage());
+  CHECK_EQUAL(parallel.metrics().nonzero, serial.storage().count());
+  CHECK_EQUAL(parallel.metrics().adds, keys.size());
+  counting_bloom_filter cserial(make_hasher(3), 1 << 21, 3);
+  counting_bloom_filter cparallel(make_hasher(3), 1 << 21, 3);
+  for (auto k : keys)
+    cserial.add(k);
+  cparallel.add(keys.begin(), keys.end(), 3);
+  size_t mismatches = 0;
+  for (size_t i = 0; i < 200000; ++i)
+    mismatches += cserial.lookup(i) != cparallel.lookup(i);
+  CHECK_EQUAL(mismatches, 0u);
+  auto ms = cserial.metrics();
+  auto mp = cparallel.metrics();
+  CHECK_EQUAL(mp.nonzero, ms.nonzero);
+  CHECK_EQUAL(mp.saturated, ms.saturated);
+  CHECK_EQUAL(mp.overflows, ms.overflows);
+  // Further bulk additions update the occupancy of a non-empty filter.
+  std::vector<uint64_t> more(50000);
+  for (size_t i = 0; i < more.size(); ++i)
+    more[i] = i * 104729;
+  for (auto k : more) {
+    serial.add(k);
+    cserial.add(k);
+  }
+  parallel.add(more.begin(), more.end(), 4);
+  cparallel.add(more.begin(), more.end(), 3);
+  auto ones = serial.storage().count();
+  CHECK_EQUAL(parallel.metrics().nonzero, ones);
+  ms = cserial.metrics();
+  mp = cparallel.metrics();
+  CHECK_EQUAL(mp.nonzero, ms.nonzero);
+  CHECK_EQUAL(mp.saturated, ms.saturated);
+  CHECK_EQUAL(mp.overflows, ms.overflows);
+  // With one-bit counters, every nonzero counter is saturated.
+  counting_bloom_filter bits(make_hasher(3), 1 << 16, 1);
+  bits.add(keys.begin(), keys.end(), 2);
+  auto mb = bits.metrics();
+  auto zeros = bits.storage().count_equal(0, 1 << 16, 0);
+  CHECK_EQUAL(mb.nonzero, (1u << 16) - zeros);
+  CHECK_EQUAL(mb.saturated, mb.nonzero);
+}
+
+TEST(bloom_filter_merge) {
+  // Shards over disjoint key ranges, spanning several chunks.
+  std::vector<basic_bloom_filter> shards;
+  basic_bloom_filter expected(make_hasher(3, 7), 1 << 20);
+  for (size_t s = 0; s < 5; ++s) {
+    shards.emplace_back(make_hasher(3, 7), 1 << 20);
+    for (size_t i = s * 10000; i < (s + 1) * 10000; ++i) {
+      shards.back().add(i);
+      expected.add(i);
+    }
+  }
+  std::vector<basic_bloom_filter const*> inputs;
+  for (auto& s : shards)
+    inputs.push_back(&s);
+  auto merged = merge(inputs, 3);
+  CHECK(merged.storage() == expected.storage());
+  CHECK_EQUAL(merged.metrics().nonzero, expected.storage().count());
+  CHECK_EQUAL(merged.lookup(uint64_t{42}), 1u);
+  // Filters with different seeds are incompatible.
+  basic_bloom_filter other(make_hasher(3, 8), 1 << 20);
+  inputs.push_back(&other);
+  auto rejected = false;
+  try {
+    merge(inputs, 2);
+  } catch (std::invalid_argument const&) {
+    rejected = true;
+  }
+  CHECK(rejected);
+  // Stream the shards from files.
+  std::vector<std::string> filenames;
+  for (size_t s = 0; s < shards.size(); ++s) {
+    filenames.push_back("bf-test-merge-" + std::to_string(s) + ".bin");
+    std::ofstream out{filenames.back(), std::ios::binary};
+    shards[s].save(out);
+  }
+  auto streamed = merge_files(filenames, make_hasher(3, 7), 2);
+  CHECK(streamed.storage() == expected.storage());
+  std::ifstream in{filenames[0], std::ios::binary};
+  auto loaded = basic_bloom_filter::load(in, make_hasher(3, 7));
+  CHECK(loaded.storage() == shards[0].storage());
+  rejected = false;
+  try {
+    merge_files(filenames, make_hasher(4, 7));
+  } catch (std::invalid_argument const&) {
+    rejected = true;
+  }
+  CHECK(rejected);
+  auto rebuilt = merge_files(filenames, 2);
+  CHECK(rebuilt.storage() == expected.storage());
+  for (auto& f : filenames)
+    std::remove(f.c_str());
+  // Counters add up and saturate.
+  counting_bloom_filter c1(make_hasher(2), 100000, 3);
+  counting_bloom_filter c2(make_hasher(2), 100000, 3);
+  for (size_t i = 0; i < 5; ++i) {
+    c1.add("foo");
+    c2.add("foo");
+  }
+  c1.add("bar");
+  c2.add("baz");
+  std::vector<counting_bloom_filter const*> counters{&c1, &c2};
+  auto sum = merge(counters, 2);
+  CHECK_EQUAL(sum.lookup("foo"), 7u);
+  CHECK_EQUAL(sum.lookup("bar"), 1u);
+  CHECK_EQUAL(sum.lookup("baz"), 1u);
+  CHECK_EQUAL(sum.metrics().saturated, 2u);
+  counter_vector x(13, 5), y(13, 5);
+  for (size_t i = 0; i < 13; ++i) {
+    x.set(i, i);
+    y.set(i, 2 * i);
+  }
+  x |= y;
+  for (size_t i = 0; i < 13; ++i) {
+    auto saturated = std::min<size_t>(3 * i, x.max());
+    CHECK_EQUAL(x.count(i), saturated);
+  }
+}
+
+TEST(hasher_descriptor) {
+  auto h = make_hasher(4, 42, true);
+  auto d = describe(h);
+  CHECK(d.family == hasher_descriptor::h3);
+  CHECK_EQUAL(d.k, 4u);
+  CHECK_EQUAL(d.seed, 42u);
+  CHECK(d.double_hashing);
+  auto rebuilt = make_hasher(d);
+  std::string foo{"foo"};
+  auto o = wrap(foo);
+  CHECK(rebuilt(o) == h(o));
+  CHECK_EQUAL(fingerprint(rebuilt), fingerprint(h));
+  hasher custom = [](object const& x) {
+    return std::vector<digest>{x.size(), 3 * x.size()};
+  };
+  CHECK(describe(custom).family == hasher_descriptor::custom);
+  // Filters record their mapping and load without out-of-band configuration.
+  basic_bloom_filter bf(0.01, 1000, 7, false, true);
+  bf.add("foo");
+  auto fd = bf.descriptor();
+  CHECK(fd.mapping == hasher_descriptor::partitioned);
+  CHECK(!fd.double_hashing);
+  std::stringstream ss;
+  bf.save(ss);
+  auto loaded = basic_bloom_filter::load(ss);
+  CHECK(loaded.partitioned());
+  CHECK(loaded.compatible(bf));
+  CHECK_EQUAL(loaded.lookup("foo"), 1u);
+  basic_bloom_filter opaque(custom, 1024);
+  std::stringstream os;
+  opaque.save(os);
+  auto rejected = false;
+  try {
+    basic_bloom_filter::load(os);
+  } catch (std::runtime_error const&) {
+    rejected = true;
+  }
+  CHECK(rejected);
+  os.seekg(0);
+  CHECK(basic_bloom_filter::load(os, custom).compatible(opaque));
+  // Corrupt headers fail before allocating what they describe. The header
+  // takes 12 bytes, followed by family, mapping, k, seed, double hashing,
+  // fingerprint, and the number of cells.
+  std::stringstream saved;
+  bf.save(saved);
+  auto bytes = saved.str();
+  auto patch = [&](size_t offset, uint64_t x) {
+    auto copy = bytes;
+    std::memcpy(&copy[offset], &x, sizeof(x));
+    return copy;
+  };
+  auto corrupt = [](std::string const& input) {
+    std::stringstream in{input};
+    try {
+      basic_bloom_filter::load(in);
+    } catch (std::runtime_error const&) {
+      return true;
+    }
+    return false;
+  };
+  size_t const k_offset = 20;
+  size_t const cells_offset = 52;
+  CHECK(corrupt(bytes.substr(0, 30)));
+  CHECK(corrupt(bytes.substr(0, bytes.size() - 1)));
+  CHECK(corrupt(patch(cells_offset, uint64_t{1} << 62)));
+  CHECK(corrupt(patch(cells_offset, ~uint64_t{0})));
+  CHECK(corrupt(patch(cells_offset, 0)));
+  CHECK(corrupt(patch(cells_offset, 2)));
+  CHECK(corrupt(patch(k_offset, 0)));
+  CHECK(corrupt(patch(k_offset, uint64_t{1} << 40)));
+  CHECK(!corrupt(bytes));
+}
+
+TEST(bloom_filter_combine) {
+  basic_bloom_filter x(0.01, 1000, 1);
+  basic_bloom_filter y(0.01, 1000, 1);
+  for (size_t i = 0; i < 600; ++i)
+    x.add(i);
+  for (size_t i = 400; i < 1000; ++i)
+    y.add(i);
+  basic_bloom_filter both(0.01, 1000, 1);
+  both.merge(x);
+  both.intersect(y);
+  CHECK_EQUAL(both.lookup(uint64_t{500}), 1u);
+  CHECK_EQUAL(both.metrics().nonzero, both.storage().count());
+  x.merge(y);
+  CHECK_EQUAL(x.lookup(uint64_t{0}), 1u);
+  CHECK_EQUAL(x.lookup(uint64_t{999}), 1u);
+  CHECK_EQUAL(x.metrics().nonzero, x.storage().count());
+  // Same size and k, but a different seed or hashing mode.
+  basic_bloom_filter seeded(0.01, 1000, 2);
+  basic_bloom_filter single(0.01, 1000, 1, false);
+  CHECK(!x.compatible(seeded));
+  CHECK(!x.compatible(single));
+  auto rejected = false;
+  try {
+    x.merge(seeded);
+  } catch (std::invalid_argument const&) {
+    rejected = true;
+  }
+  CHECK(rejected);
+  // Counters add and take minima, with and without whole-block kernels.
+  for (size_t width : {4, 5}) {
+    counting_bloom_filter c1(make_hasher(3), 1000, width);
+    counting_bloom_filter c2(make_hasher(3), 1000, width);
+    for (size_t i = 0; i < 3; ++i)
+      c1.add("foo");
+    c2.add("foo");
+    c2.add("bar");
+    counting_bloom_filter sum(make_hasher(3), 1000, width);
+    sum.merge(c1);
+    sum.merge(c2);
+    CHECK_EQUAL(sum.lookup("foo"), 4u);
+    CHECK_EQUAL(sum.lookup("bar"), 1u);
+    c1.intersect(c2);
+    CHECK_EQUAL(c1.lookup("foo"), 1u);
+    CHECK_EQUAL(c1.lookup("bar"), 0u);
+    CHECK_EQUAL(c1.metrics().nonzero, 3u);
+  }
+  // The halves of A2 filters pair by hasher regardless of rotations.
+  a2_bloom_filter a(3, 4096, 100, 1, 2);
+  a2_bloom_filter b(3, 4096, 100, 1, 2);
+  for (size_t i = 0; i < 150; ++i)
+    b.add(i);
+  a.add("foo");
+  a.merge(b);
+  CHECK_EQUAL(a.lookup("foo"), 1u);
+  CHECK_EQUAL(a.lookup(uint64_t{149}), 1u);
+  a.intersect(b);
+  CHECK_EQUAL(a.lookup(uint64_t{149}), 1u);
+  a2_bloom_filter c(3, 4096, 50, 1, 2);
+  rejected = false;
+  try {
+    a.merge(c);
+  } catch (std::invalid_argument const&) {
+    rejected = true;
+  }
+  CHECK(rejected);
+}
+
+TEST(bloom_filter_persistence) {
+  counting_bloom_filter cbf(make_hasher(3, 5, true), 4096, 4, true);
+  for (size_t i = 0; i < 300; ++i)
+    cbf.add(i);
+  cbf.add(uint64_t{42});
+  std::stringstream ss;
+  cbf.save(ss);
+  auto loaded = counting_bloom_filter::load(ss);
+  CHECK(loaded.compatible(cbf));
+  CHECK(loaded.partitioned());
+  CHECK(loaded.storage().bits() == cbf.storage().bits());
+  auto count = cbf.lookup(uint64_t{42});
+  CHECK_EQUAL(loaded.lookup(uint64_t{42}), count);
+  // Load both kinds of filters from memory-mapped files.
+  basic_bloom_filter bf(0.01, 1000, 3);
+  for (size_t i = 0; i < 500; ++i)
+    bf.add(i);
+  std::string basic_file{"bf-test-basic.bin"};
+  std::string counting_file{"bf-test-counting.bin"};
+  {
+    std::ofstream out{basic_file, std::ios::binary};
+    bf.save(out);
+  }
+  {
+    std::ofstream out{counting_file, std::ios::binary};
+    cbf.save(out);
+  }
+  auto mapped = basic_bloom_filter::load(basic_file);
+  CHECK(mapped.storage() == bf.storage());
+  CHECK_EQUAL(mapped.lookup(uint64_t{499}), 1u);
+  auto mapped_counting = counting_bloom_filter::load(counting_file);
+  CHECK(mapped_counting.storage().bits() == cbf.storage().bits());
+  auto rejected = false;
+  try {
+    counting_bloom_filter::load(basic_file);
+  } catch (std::runtime_error const&) {
+    rejected = true;
+  }
+  CHECK(rejected);
+  // Corrupt headers fail before allocating. The width follows the 12-byte
+  // header, the 32-byte descriptor, the fingerprint, and the cells.
+  std::stringstream saved;
+  cbf.save(saved);
+  auto bytes = saved.str();
+  auto corrupt = [&](size_t offset, uint64_t x) {
+    auto copy = bytes;
+    std::memcpy(&copy[offset], &x, sizeof(x));
+    std::stringstream in{copy};
+    try {
+      counting_bloom_filter::load(in);
+    } catch (std::runtime_error const&) {
+      return true;
+    }
+    return false;
+  };
+  CHECK(corrupt(52, uint64_t{1} << 62));
+  CHECK(corrupt(52, 0));
+  CHECK(corrupt(60, uint64_t{1} << 61));
+  CHECK(corrupt(60, 65));
+  CHECK(corrupt(20, 0));
+  std::remove(basic_file.c_str());
+  std::remove(counting_file.c_str());
+}